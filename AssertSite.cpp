@@ -0,0 +1,34 @@
+#include "Options.h"
+
+#ifdef USE_ASSERT_SITES
+#include "AssertSite.h"
+#include <cstddef>
+
+// Section bounds defined by the linker. Weak so a program without any 
+// assertion sites still links.
+extern AssertSite __start_assert_sites[] __attribute__((weak));
+extern AssertSite __stop_assert_sites[] __attribute__((weak));
+
+uint32_t AssertSiteCount()
+{
+    if (__start_assert_sites == NULL)
+        return 0;
+    return (uint32_t)(__stop_assert_sites - __start_assert_sites);
+}
+
+AssertSite* AssertSiteGet(uint32_t id)
+{
+    if (id >= AssertSiteCount())
+        return NULL;
+    return &__start_assert_sites[id];
+}
+
+uint16_t AssertSiteId(const AssertSite* site)
+{
+    if (site < __start_assert_sites || site >= __stop_assert_sites)
+        return ASSERT_SITE_NONE;
+    uintptr_t id = (uintptr_t)(site - __start_assert_sites);
+    return id < ASSERT_SITE_NONE ? (uint16_t)id : ASSERT_SITE_NONE;
+}
+
+#endif
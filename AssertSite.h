@@ -0,0 +1,62 @@
+#ifndef _ASSERT_SITE_H
+#define _ASSERT_SITE_H
+
+// Assertion site registry. Each ASSERT() and ASSERT_TRUE() site emits a
+// static descriptor into the assert_sites linker section. The linker places
+// all descriptors in one array bounded by __start_assert_sites and
+// __stop_assert_sites, so each site has a dense 16-bit id (its array index)
+// and the program enumerates its sites without any startup registration.
+// The core dump stores the site id instead of the file name; the decoder 
+// reads the site file and line from the executable (--elf). GCC and Clang
+// ELF targets only.
+
+#include <stdint.h>
+#include <atomic>
+
+#if !defined(__GNUC__)
+#error "USE_ASSERT_SITES requires GCC or Clang and an ELF target"
+#endif
+
+// Linker section holding the site descriptors. Must be a C identifier.
+#define ASSERT_SITE_SECTION     "assert_sites"
+
+// Descriptor size. One cache line, so site failure counters never share a line.
+#define ASSERT_SITE_SIZE        64
+
+// Site id of a core dump not caused by an assertion
+#define ASSERT_SITE_NONE        0xFFFF
+
+/// Static assertion site descriptor. The layout is read by the decoder.
+struct alignas(ASSERT_SITE_SIZE) AssertSite
+{
+    constexpr AssertSite(const char* file, uint32_t line) :
+        Failures(0), File(file), Line(line)
+    {
+    }
+
+    std::atomic<uint64_t> Failures;     // Failures at this site since startup
+    const char* File;
+    uint32_t Line;
+};
+
+static_assert(sizeof(AssertSite) == ASSERT_SITE_SIZE, "AssertSite must fill one cache line");
+
+/// Define the static descriptor of the enclosing assertion site
+#define ASSERT_SITE_DEFINE(name) \
+    static AssertSite name __attribute__((section(ASSERT_SITE_SECTION), used))(__FILE__, __LINE__)
+
+/// Get the number of assertion sites in the program
+/// @return The number of sites. Site ids are 0 to count - 1.
+uint32_t AssertSiteCount();
+
+/// Get an assertion site by id
+/// @param[in] id - the site id
+/// @return A pointer to the site or NULL if the id is invalid.
+AssertSite* AssertSiteGet(uint32_t id);
+
+/// Get the id of an assertion site
+/// @param[in] site - the site descriptor
+/// @return The dense site id, or ASSERT_SITE_NONE if not a registered site.
+uint16_t AssertSiteId(const AssertSite* site);
+
+#endif
@@ -0,0 +1,51 @@
+#include "ClockCalibrator.h"
+#include "Fault.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+static uint32_t _intervalMs = CLOCK_CALIBRATOR_INTERVAL_MS;
+static std::thread _thread;
+static std::mutex _lock;
+static std::condition_variable _wake;
+static bool _stop = false;
+
+static void CalibratorThread()
+{
+#ifdef USE_LINUX_SIGNALS
+    SignalFaultThread signalFaultThread;
+#endif
+    std::unique_lock<std::mutex> lock(_lock);
+    uint32_t waitMs = CLOCK_CALIBRATOR_FIRST_MS;
+    while (!_wake.wait_for(lock, std::chrono::milliseconds(waitMs), [] { return _stop; }))
+    {
+        CoreDumpClockCalibrate();
+        waitMs = _intervalMs;
+    }
+}
+
+bool ClockCalibratorStart(uint32_t intervalMs)
+{
+    if (_thread.joinable())
+        return false;
+
+    _intervalMs = intervalMs != 0 ? intervalMs : CLOCK_CALIBRATOR_INTERVAL_MS;
+    _stop = false;
+    CoreDumpClockCalibrate();
+    _thread = std::thread(CalibratorThread);
+    return true;
+}
+
+void ClockCalibratorStop()
+{
+    if (!_thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _stop = true;
+    }
+    _wake.notify_all();
+    _thread.join();
+}
@@ -0,0 +1,28 @@
+#ifndef _CLOCK_CALIBRATOR_H
+#define _CLOCK_CALIBRATOR_H
+
+// Periodic core dump clock calibration. A background thread calls
+// CoreDumpClockCalibrate() shortly after start, so the cycle counter
+// frequency is measured against the startup calibration, and then at a
+// fixed interval so the decoder's wall-clock reconstruction does not drift.
+
+#include "CoreDump.h"
+#include <stdint.h>
+
+// Default calibration interval
+#define CLOCK_CALIBRATOR_INTERVAL_MS    (60 * 1000)
+
+// Delay of the first calibration. At least the 10 ms needed to measure the
+// cycle counter frequency.
+#define CLOCK_CALIBRATOR_FIRST_MS       100
+
+/// Calibrate the clock and start the calibration thread.
+/// @param[in] intervalMs - the calibration interval, or 0 for
+///     CLOCK_CALIBRATOR_INTERVAL_MS
+/// @return True if started; false if already started.
+bool ClockCalibratorStart(uint32_t intervalMs);
+
+/// Stop the calibration thread. The last calibration remains in use.
+void ClockCalibratorStop();
+
+#endif
@@ -0,0 +1,331 @@
+// Local crash collector daemon. Receives serialized CoreDumpData records, raw
+// or as compressed streams (Compress.h), over a Unix-domain SOCK_SEQPACKET 
+// socket and appends them to a DumpStore. A compressed record is stored as
+// received and flagged DUMP_RECORD_COMPRESSED. Build
+// the collector using the same Options.h settings as the target application
+// so the CoreDumpData layout matches.
+//
+// Usage: CoreDumpCollector [--socket <path>] [--store <path>]
+//
+// Senders never wait on the collector (see CollectorSend()). All records
+// received while the previous batch was being flushed are written together
+// with one fdatasync, so throughput rises with the arrival rate during a
+// crash storm. Records with an already stored stack hash are written as
+// header-only duplicates. A sender is not told of a failed commit, so a
+// failed batch is retried until it is durable.
+
+#include "CoreDump.h"
+#include "CollectorClient.h"
+#include "Compress.h"
+#include "DumpStore.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Maximum records received between commits
+#define COLLECTOR_BATCH     64
+
+#define MAX_EVENTS          256
+
+// Retry delays of a failed commit
+#define COMMIT_RETRY_MIN_MS 10
+#define COMMIT_RETRY_MAX_MS (5 * 1000)
+
+// A receive slot holds one record, raw or an incompressible compressed 
+// stream, plus one byte to detect oversized records
+#define SLOT_SIZE           (COMPRESS_STREAM_BOUND(sizeof(CoreDumpData)) + 1)
+
+struct CollectorStats
+{
+    uint64_t Received;
+    uint64_t Dropped;
+    uint64_t Commits;
+};
+
+static volatile sig_atomic_t _stop = 0;
+
+static void StopHandler(int signalNumber)
+{
+    (void)signalNumber;
+    _stop = 1;
+}
+
+// Validate a received record before storing. A compressed record is 
+// decompressed to validate and hash it.
+// @param[out] stackHash - the record stack hash
+// @param[out] flags - the record flags to store
+static bool IsValidRecord(const uint8_t* data, size_t length, uint64_t* stackHash, uint32_t* flags)
+{
+    // Large; don't place on the stack
+    static CoreDumpData decompressed;
+    const CoreDumpData* coreDumpData = (const CoreDumpData*)data;
+    *flags = 0;
+    if (IsCompressed(data, length))
+    {
+        if (DecompressStream(data, length, &decompressed, sizeof(decompressed)) != (long)sizeof(decompressed))
+            return false;
+        coreDumpData = &decompressed;
+        *flags = DUMP_RECORD_COMPRESSED;
+    }
+    else if (length != sizeof(CoreDumpData))
+        return false;
+
+    if (coreDumpData->Key != KEY_CORE_DUMP_STORED || coreDumpData->NotKey != ~KEY_CORE_DUMP_STORED)
+        return false;
+    if (CoreDumpCrc(coreDumpData) != coreDumpData->Crc)
+        return false;
+    *stackHash = DumpStackHash(coreDumpData);
+    return true;
+}
+
+static int Listen(const char* socketPath)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(addr.sun_path))
+        return -1;
+    strcpy(addr.sun_path, socketPath);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    unlink(socketPath);
+    if (bind(fd, (const struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+class Collector
+{
+public:
+    Collector(DumpStore* store) :
+        m_store(store),
+        m_slots(COLLECTOR_BATCH * SLOT_SIZE),
+        m_used(0)
+    {
+        memset(&m_stats, 0, sizeof(m_stats));
+        memset(m_msgs, 0, sizeof(m_msgs));
+        for (int i = 0; i < COLLECTOR_BATCH; i++)
+        {
+            m_iov[i].iov_base = &m_slots[i * SLOT_SIZE];
+            m_iov[i].iov_len = SLOT_SIZE;
+            m_msgs[i].msg_hdr.msg_iov = &m_iov[i];
+            m_msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+
+    /// Receive all pending records on a connection.
+    /// @return False if the sender closed the connection.
+    bool Receive(int fd)
+    {
+        for (;;)
+        {
+            if (m_used == COLLECTOR_BATCH)
+                Commit();
+
+            int cnt = recvmmsg(fd, &m_msgs[m_used], COLLECTOR_BATCH - m_used, MSG_DONTWAIT, NULL);
+            if (cnt < 0)
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+            for (int i = 0; i < cnt; i++)
+            {
+                struct mmsghdr* msg = &m_msgs[m_used];
+                const uint8_t* data = (const uint8_t*)m_iov[m_used].iov_base;
+
+                // A zero length message is the end of the connection
+                if (msg->msg_len == 0)
+                    return false;
+
+                // An invalid record holds its slot until the next commit
+                int slot = m_used++;
+                m_valid[slot] = !(msg->msg_hdr.msg_flags & MSG_TRUNC) && 
+                    IsValidRecord(data, msg->msg_len, &m_hashes[slot], &m_flags[slot]);
+                m_stats.Received++;
+                if (!m_valid[slot])
+                {
+                    m_stats.Dropped++;
+                    continue;
+                }
+                m_store->Append(data, msg->msg_len, m_hashes[slot], m_flags[slot]);
+            }
+        }
+    }
+
+    /// Make all received records durable and free the receive slots. A 
+    /// failed commit is retried from the receive slots; receiving waits 
+    /// meanwhile. Only stopping the collector gives up the batch.
+    void Commit()
+    {
+        if (m_used == 0)
+            return;
+
+        uint32_t retryMs = COMMIT_RETRY_MIN_MS;
+        while (!m_store->Commit())
+        {
+            fprintf(stderr, "Dump store commit failed: %s\n", strerror(errno));
+            if (_stop)
+            {
+                m_stats.Dropped += ValidCount();
+                break;
+            }
+            usleep(retryMs * 1000);
+            retryMs = retryMs * 2 < COMMIT_RETRY_MAX_MS ? retryMs * 2 : COMMIT_RETRY_MAX_MS;
+
+            // The failed commit dropped the queued records
+            for (int i = 0; i < m_used; i++)
+            {
+                if (m_valid[i])
+                    m_store->Append(m_iov[i].iov_base, m_msgs[i].msg_len, m_hashes[i], m_flags[i]);
+            }
+        }
+        m_stats.Commits++;
+        m_used = 0;
+    }
+
+    bool Pending() const { return m_used != 0; }
+    const CollectorStats& Stats() const { return m_stats; }
+
+private:
+    int ValidCount() const
+    {
+        int cnt = 0;
+        for (int i = 0; i < m_used; i++)
+            cnt += m_valid[i];
+        return cnt;
+    }
+
+    DumpStore* m_store;
+    std::vector<uint8_t> m_slots;
+    struct iovec m_iov[COLLECTOR_BATCH];
+    struct mmsghdr m_msgs[COLLECTOR_BATCH];
+    bool m_valid[COLLECTOR_BATCH];
+    uint64_t m_hashes[COLLECTOR_BATCH];
+    uint32_t m_flags[COLLECTOR_BATCH];
+    int m_used;
+    CollectorStats m_stats;
+};
+
+int main(int argc, char* argv[])
+{
+    const char* socketPath = COLLECTOR_SOCKET_PATH;
+    const char* storePath = "coredumps.store";
+
+    for (int a = 1; a < argc; a++)
+    {
+        if (strcmp(argv[a], "--socket") == 0 && a + 1 < argc)
+            socketPath = argv[++a];
+        else if (strcmp(argv[a], "--store") == 0 && a + 1 < argc)
+            storePath = argv[++a];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--socket <path>] [--store <path>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    static DumpStore store;
+    if (!store.Open(storePath))
+    {
+        fprintf(stderr, "Cannot open dump store %s\n", storePath);
+        return 1;
+    }
+
+    int listenFd = Listen(socketPath);
+    if (listenFd < 0)
+    {
+        fprintf(stderr, "Cannot listen on %s: %s\n", socketPath, strerror(errno));
+        return 1;
+    }
+
+    // Stop on SIGINT or SIGTERM. No SA_RESTART so epoll_wait() returns.
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = StopHandler;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+
+    static Collector collector(&store);
+    struct epoll_event events[MAX_EVENTS];
+
+    while (!_stop)
+    {
+        // Wait only when nothing is pending; otherwise commit once no more
+        // records are immediately available
+        int cnt = epoll_wait(epollFd, events, MAX_EVENTS, collector.Pending() ? 0 : -1);
+        if (cnt < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (cnt == 0)
+        {
+            collector.Commit();
+            continue;
+        }
+
+        for (int e = 0; e < cnt; e++)
+        {
+            int fd = events[e].data.fd;
+            if (fd == listenFd)
+            {
+                // A crashing sender usually sends and closes before the 
+                // connection is accepted; receive before polling
+                int connFd;
+                while ((connFd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+                {
+                    if (!collector.Receive(connFd))
+                    {
+                        close(connFd);
+                        continue;
+                    }
+                    event.events = EPOLLIN;
+                    event.data.fd = connFd;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, connFd, &event);
+                }
+                continue;
+            }
+
+            if (!collector.Receive(fd) || (events[e].events & (EPOLLHUP | EPOLLERR)))
+                close(fd);
+        }
+    }
+
+    // Drain connections still waiting to be accepted
+    int connFd;
+    while ((connFd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+    {
+        collector.Receive(connFd);
+        close(connFd);
+    }
+
+    collector.Commit();
+    store.Close();
+    close(listenFd);
+    unlink(socketPath);
+
+    const CollectorStats& stats = collector.Stats();
+    printf("Received %llu, dropped %llu, stored %llu (%llu duplicates), commits %llu\n",
+        (unsigned long long)stats.Received, (unsigned long long)stats.Dropped,
+        (unsigned long long)store.RecordCount(), (unsigned long long)store.DuplicateCount(),
+        (unsigned long long)stats.Commits);
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "CollectorClient.h"
+
+#ifdef __linux__
+
+#include "Compress.h"
+#include <cstring>
+#include <mutex>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+bool CollectorSend(const char* socketPath, const void* data, size_t length)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(addr.sun_path))
+        return false;
+    strcpy(addr.sun_path, socketPath);
+
+    // SOCK_SEQPACKET preserves record boundaries. A non-blocking connect 
+    // fails with EAGAIN instead of waiting when the listen backlog is full.
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+
+    // The whole record must fit within the send buffer
+    int sendSize = (int)(length + 4096);
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendSize, sizeof(sendSize));
+
+    bool sent = false;
+    if (connect(fd, (const struct sockaddr*)&addr, sizeof(addr)) == 0)
+        sent = send(fd, data, length, MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t)length;
+    close(fd);
+    return sent;
+}
+
+bool CollectorSendDump(const char* socketPath, const CoreDumpData* coreDumpData)
+{
+    // Large; don't place on the stack. The lock serializes senders sharing
+    // the compressor state and output buffer.
+    static CompressState state;
+    static uint8_t stream[COMPRESS_STREAM_BOUND(sizeof(CoreDumpData))];
+    static std::mutex lock;
+
+    std::lock_guard<std::mutex> guard(lock);
+    size_t length = CompressBuffer(&state, coreDumpData, sizeof(CoreDumpData), stream, sizeof(stream));
+    if (length == 0)
+        return false;
+    return CollectorSend(socketPath, stream, length);
+}
+
+#else
+
+bool CollectorSend(const char* socketPath, const void* data, size_t length)
+{
+    (void)socketPath;
+    (void)data;
+    (void)length;
+    return false;
+}
+
+bool CollectorSendDump(const char* socketPath, const CoreDumpData* coreDumpData)
+{
+    (void)socketPath;
+    (void)coreDumpData;
+    return false;
+}
+
+#endif
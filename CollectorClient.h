@@ -0,0 +1,27 @@
+#ifndef _COLLECTOR_CLIENT_H
+#define _COLLECTOR_CLIENT_H
+
+#include "CoreDump.h"
+#include <stddef.h>
+
+// Default Unix-domain socket of the local crash collector daemon (Collector/)
+#define COLLECTOR_SOCKET_PATH   "/tmp/coredump-collector.sock"
+
+/// Send one serialized core dump record to the local collector. Never blocks;
+/// if the collector is not running or is backlogged the record is not sent
+/// and the caller retries later.
+/// @param[in] socketPath - the collector socket path
+/// @param[in] data - the record to send, e.g. a CoreDumpData structure
+/// @param[in] length - the record length in bytes
+/// @return True if the collector accepted the record.
+bool CollectorSend(const char* socketPath, const void* data, size_t length);
+
+/// Compress a core dump and send it to the local collector as a compressed
+/// stream (Compress.h). The collector stores the stream as received and 
+/// flags the record DUMP_RECORD_COMPRESSED. Never blocks, as CollectorSend().
+/// @param[in] socketPath - the collector socket path
+/// @param[in] coreDumpData - the core dump to send
+/// @return True if the collector accepted the record.
+bool CollectorSendDump(const char* socketPath, const CoreDumpData* coreDumpData);
+
+#endif 
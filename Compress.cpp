@@ -0,0 +1,369 @@
+#include "Compress.h"
+#include <cstring>
+
+// LZ4 block format limits
+#define MIN_MATCH       4
+#define LAST_LITERALS   5       // The last bytes of a block are literals
+#define MF_LIMIT        12      // The last match starts before this
+#define MAX_DISTANCE    65535
+#define SKIP_TRIGGER    6       // Search step grows after 2^SKIP_TRIGGER misses
+
+static_assert(COMPRESS_BLOCK_SIZE <= 65535, "Hash table positions are 16-bit");
+
+static inline uint32_t Read32(const uint8_t* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint64_t Read64(const uint8_t* p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t Hash(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - COMPRESS_HASH_BITS);
+}
+
+static inline void WriteLE32(uint8_t* p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static inline uint32_t ReadLE32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Count the matching bytes at two positions, up to limit
+static inline size_t MatchLength(const uint8_t* p, const uint8_t* ref, const uint8_t* limit)
+{
+    const uint8_t* start = p;
+    while (p + 8 <= limit)
+    {
+        uint64_t diff = Read64(p) ^ Read64(ref);
+        if (diff != 0)
+        {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return (p - start) + (__builtin_ctzll(diff) >> 3);
+#else
+            break;
+#endif
+        }
+        p += 8;
+        ref += 8;
+    }
+    while (p < limit && *p == *ref)
+    {
+        p++;
+        ref++;
+    }
+    return p - start;
+}
+
+// Write an LZ4 length extension: 255 bytes then the remainder
+static inline uint8_t* WriteLength(uint8_t* op, size_t length)
+{
+    for (; length >= 255; length -= 255)
+        *op++ = 255;
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+// Write a sequence of literals and an optional match. Returns NULL if the
+// destination is too small.
+static uint8_t* WriteSequence(uint8_t* op, uint8_t* opEnd, const uint8_t* literals,
+    size_t literalLength, size_t offset, size_t matchLength)
+{
+    // Token, length extensions, literals and offset
+    if ((size_t)(opEnd - op) < 1 + literalLength + literalLength / 255 + 1 + 2 + matchLength / 255 + 1)
+        return NULL;
+
+    uint8_t* token = op++;
+    *token = (uint8_t)((literalLength >= 15 ? 15 : literalLength) << 4);
+    if (literalLength >= 15)
+        op = WriteLength(op, literalLength - 15);
+    memcpy(op, literals, literalLength);
+    op += literalLength;
+
+    if (matchLength == 0)
+        return op;
+
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    matchLength -= MIN_MATCH;
+    *token |= (uint8_t)(matchLength >= 15 ? 15 : matchLength);
+    if (matchLength >= 15)
+        op = WriteLength(op, matchLength - 15);
+    return op;
+}
+
+size_t CompressBlock(CompressState* state, const void* data, size_t length, 
+    void* dest, size_t capacity)
+{
+    const uint8_t* src = (const uint8_t*)data;
+    uint8_t* op = (uint8_t*)dest;
+    uint8_t* opEnd = op + capacity;
+    uint16_t* table = state->Table;
+    size_t anchor = 0;
+
+    if (length > COMPRESS_BLOCK_SIZE)
+        return 0;
+
+    if (length >= MF_LIMIT + 1)
+    {
+        const size_t mfLimit = length - MF_LIMIT;
+        const uint8_t* matchLimit = src + length - LAST_LITERALS;
+        size_t ip = 1;
+        table[Hash(Read32(src))] = 0;
+
+        for (;;)
+        {
+            // Find a match. Stale table entries are rejected by the compare.
+            size_t ref = 0;
+            uint32_t misses = 1 << SKIP_TRIGGER;
+            bool found = false;
+            while (ip <= mfLimit)
+            {
+                uint32_t sequence = Read32(src + ip);
+                uint32_t h = Hash(sequence);
+                ref = table[h];
+                table[h] = (uint16_t)ip;
+                if (ref < ip && Read32(src + ref) == sequence)
+                {
+                    found = true;
+                    break;
+                }
+
+                // Stack data repeats at word distance (zero fill, adjacent 
+                // pointers sharing the upper bytes)
+                if (ip >= 8 && Read32(src + ip - 8) == sequence)
+                {
+                    ref = ip - 8;
+                    found = true;
+                    break;
+                }
+                ip += misses++ >> SKIP_TRIGGER;
+            }
+            if (!found)
+                break;
+
+            // Extend the match backwards over pending literals
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+            {
+                ip--;
+                ref--;
+            }
+
+            size_t matchLength = MIN_MATCH + 
+                MatchLength(src + ip + MIN_MATCH, src + ref + MIN_MATCH, matchLimit);
+            op = WriteSequence(op, opEnd, src + anchor, ip - anchor, ip - ref, matchLength);
+            if (op == NULL)
+                return 0;
+
+            ip += matchLength;
+            anchor = ip;
+            if (ip > mfLimit)
+                break;
+            table[Hash(Read32(src + ip - 2))] = (uint16_t)(ip - 2);
+        }
+    }
+
+    // The block always ends with literals
+    op = WriteSequence(op, opEnd, src + anchor, length - anchor, 0, 0);
+    if (op == NULL)
+        return 0;
+    return op - (uint8_t*)dest;
+}
+
+int DecompressBlock(const void* data, size_t length, void* dest, size_t capacity)
+{
+    const uint8_t* ip = (const uint8_t*)data;
+    const uint8_t* ipEnd = ip + length;
+    uint8_t* op = (uint8_t*)dest;
+    uint8_t* opEnd = op + capacity;
+
+    while (ip < ipEnd)
+    {
+        uint8_t token = *ip++;
+
+        // Literals
+        size_t literalLength = token >> 4;
+        if (literalLength == 15)
+        {
+            uint8_t b;
+            do
+            {
+                if (ip >= ipEnd)
+                    return -1;
+                b = *ip++;
+                literalLength += b;
+            } while (b == 255);
+        }
+        if (literalLength > (size_t)(ipEnd - ip) || literalLength > (size_t)(opEnd - op))
+            return -1;
+        memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        // The last sequence has no match
+        if (ip >= ipEnd)
+            break;
+
+        // Match
+        if (ipEnd - ip < 2)
+            return -1;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - (uint8_t*)dest))
+            return -1;
+
+        size_t matchLength = token & 0x0F;
+        if (matchLength == 15)
+        {
+            uint8_t b;
+            do
+            {
+                if (ip >= ipEnd)
+                    return -1;
+                b = *ip++;
+                matchLength += b;
+            } while (b == 255);
+        }
+        matchLength += MIN_MATCH;
+        if (matchLength > (size_t)(opEnd - op))
+            return -1;
+
+        const uint8_t* ref = op - offset;
+        if (offset >= matchLength)
+        {
+            memcpy(op, ref, matchLength);
+            op += matchLength;
+        }
+        else
+        {
+            // Overlapping copy repeats the last offset bytes
+            for (size_t i = 0; i < matchLength; i++)
+                *op++ = *ref++;
+        }
+    }
+    return (int)(op - (uint8_t*)dest);
+}
+
+bool CompressStream(CompressState* state, const void* data, size_t length,
+    CompressWriteFunc write, void* context)
+{
+    const uint8_t* src = (const uint8_t*)data;
+    uint8_t header[COMPRESS_HEADER_SIZE];
+
+    memset(state->Table, 0, sizeof(state->Table));
+
+    WriteLE32(header, COMPRESS_MAGIC);
+    WriteLE32(header + 4, (uint32_t)length);
+    if (!write(context, header, sizeof(header)))
+        return false;
+
+    for (size_t offset = 0; offset < length; offset += COMPRESS_BLOCK_SIZE)
+    {
+        size_t blockLength = length - offset;
+        if (blockLength > COMPRESS_BLOCK_SIZE)
+            blockLength = COMPRESS_BLOCK_SIZE;
+
+        // Store the block uncompressed if compression doesn't help
+        size_t compressed = CompressBlock(state, src + offset, blockLength, 
+            state->Block, blockLength);
+        bool ok;
+        if (compressed != 0)
+        {
+            WriteLE32(header, (uint32_t)compressed);
+            ok = write(context, header, 4) && write(context, state->Block, compressed);
+        }
+        else
+        {
+            WriteLE32(header, (uint32_t)blockLength | COMPRESS_BLOCK_STORED);
+            ok = write(context, header, 4) && write(context, src + offset, blockLength);
+        }
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+/// CompressBuffer() output position
+struct BufferWriter
+{
+    uint8_t* Dest;
+    size_t Capacity;
+    size_t Used;
+};
+
+static bool WriteBuffer(void* context, const void* data, size_t length)
+{
+    BufferWriter* writer = (BufferWriter*)context;
+    if (length > writer->Capacity - writer->Used)
+        return false;
+    memcpy(writer->Dest + writer->Used, data, length);
+    writer->Used += length;
+    return true;
+}
+
+size_t CompressBuffer(CompressState* state, const void* data, size_t length,
+    void* dest, size_t capacity)
+{
+    BufferWriter writer = { (uint8_t*)dest, capacity, 0 };
+    if (!CompressStream(state, data, length, WriteBuffer, &writer))
+        return 0;
+    return writer.Used;
+}
+
+bool IsCompressed(const void* data, size_t length)
+{
+    return length >= COMPRESS_HEADER_SIZE && ReadLE32((const uint8_t*)data) == COMPRESS_MAGIC;
+}
+
+long DecompressStream(const void* data, size_t length, void* dest, size_t capacity)
+{
+    const uint8_t* ip = (const uint8_t*)data;
+    const uint8_t* ipEnd = ip + length;
+    uint8_t* op = (uint8_t*)dest;
+
+    if (!IsCompressed(data, length))
+        return -1;
+    size_t total = ReadLE32(ip + 4);
+    if (total > capacity)
+        return -1;
+    ip += COMPRESS_HEADER_SIZE;
+
+    size_t size = 0;
+    while (size < total)
+    {
+        if (ipEnd - ip < 4)
+            return -1;
+        uint32_t blockHeader = ReadLE32(ip);
+        ip += 4;
+        size_t payload = blockHeader & ~COMPRESS_BLOCK_STORED;
+        size_t expected = total - size < COMPRESS_BLOCK_SIZE ? total - size : COMPRESS_BLOCK_SIZE;
+        if (payload > (size_t)(ipEnd - ip))
+            return -1;
+
+        if (blockHeader & COMPRESS_BLOCK_STORED)
+        {
+            if (payload != expected)
+                return -1;
+            memcpy(op + size, ip, payload);
+        }
+        else if (DecompressBlock(ip, payload, op + size, expected) != (int)expected)
+            return -1;
+        ip += payload;
+        size += expected;
+    }
+    return (long)size;
+}
+
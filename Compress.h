@@ -0,0 +1,94 @@
+#ifndef _COMPRESS_H
+#define _COMPRESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Compressed stream format. An 8-byte header (magic, uncompressed length) 
+// followed by blocks. Each block has a 4-byte little endian header holding 
+// the payload length; COMPRESS_BLOCK_STORED marks an uncompressed payload.
+// Block payloads use the LZ4 block sequence format and are independent, so 
+// a stream is decompressed one block at a time.
+#define COMPRESS_MAGIC          0x315A4443      // "CDZ1"
+#define COMPRESS_HEADER_SIZE    8
+#define COMPRESS_BLOCK_SIZE     (32 * 1024)
+#define COMPRESS_BLOCK_STORED   0x80000000
+#define COMPRESS_HASH_BITS      12
+
+// Worst case compressed size of a length byte block
+#define COMPRESS_BLOCK_BOUND(length)    ((length) + (length) / 255 + 16)
+
+// Worst case compressed stream size of length bytes. An incompressible 
+// block is stored.
+#define COMPRESS_STREAM_BOUND(length)   (COMPRESS_HEADER_SIZE + (length) + \
+    ((length) + COMPRESS_BLOCK_SIZE - 1) / COMPRESS_BLOCK_SIZE * 4)
+
+/// Compressor working memory. No allocation occurs; place in static RAM as 
+/// it is too large for a fault handler stack.
+struct CompressState
+{
+    uint16_t Table[1 << COMPRESS_HASH_BITS];
+    uint8_t Block[COMPRESS_BLOCK_SIZE];
+};
+
+/// Compressed stream output callback
+/// @param[in] context - the caller context passed to CompressStream()
+/// @param[in] data - the compressed data
+/// @param[in] length - the compressed data length in bytes
+/// @return Return false to abort compression.
+typedef bool (*CompressWriteFunc)(void* context, const void* data, size_t length);
+
+/// Compress a single block.
+/// @param[in] state - the compressor working memory
+/// @param[in] data - the data to compress
+/// @param[in] length - the data length. Must not exceed COMPRESS_BLOCK_SIZE.
+/// @param[out] dest - the compressed data destination
+/// @param[in] capacity - the destination size in bytes
+/// @return The compressed size, or 0 if the destination is too small.
+size_t CompressBlock(CompressState* state, const void* data, size_t length, 
+    void* dest, size_t capacity);
+
+/// Decompress a single block.
+/// @param[in] data - the compressed block payload
+/// @param[in] length - the payload length in bytes
+/// @param[out] dest - the decompressed data destination
+/// @param[in] capacity - the destination size in bytes
+/// @return The decompressed size, or -1 if the payload is malformed.
+int DecompressBlock(const void* data, size_t length, void* dest, size_t capacity);
+
+/// Compress a buffer, such as a CoreDumpData structure or a memory snapshot, 
+/// into a compressed stream. The stream is written one block at a time.
+/// @param[in] state - the compressor working memory
+/// @param[in] data - the data to compress
+/// @param[in] length - the data length in bytes
+/// @param[in] write - the output callback, called for each header and block
+/// @param[in] context - passed to the output callback
+/// @return True if the whole stream was written.
+bool CompressStream(CompressState* state, const void* data, size_t length,
+    CompressWriteFunc write, void* context);
+
+/// Compress a buffer into a compressed stream in memory.
+/// @param[in] state - the compressor working memory
+/// @param[in] data - the data to compress
+/// @param[in] length - the data length in bytes
+/// @param[out] dest - the compressed stream destination
+/// @param[in] capacity - the destination size, e.g. COMPRESS_STREAM_BOUND(length)
+/// @return The compressed stream size, or 0 if the destination is too small.
+size_t CompressBuffer(CompressState* state, const void* data, size_t length,
+    void* dest, size_t capacity);
+
+/// Returns true if a buffer starts with a compressed stream header
+/// @param[in] data - the buffer
+/// @param[in] length - the buffer length in bytes
+bool IsCompressed(const void* data, size_t length);
+
+/// Decompress a compressed stream held in memory.
+/// @param[in] data - the compressed stream
+/// @param[in] length - the compressed stream length in bytes
+/// @param[out] dest - the decompressed data destination
+/// @param[in] capacity - the destination size in bytes
+/// @return The decompressed size, or -1 if the stream is malformed, 
+///     truncated or larger than capacity.
+long DecompressStream(const void* data, size_t length, void* dest, size_t capacity);
+
+#endif 
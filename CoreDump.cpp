@@ -1,6 +1,50 @@
 #include "CoreDump.h"
 #include "Options.h"
+#include "Crc32c.h"
 #include <cstring>
+#include <cstddef>
+
+#include <atomic>
+
+#ifdef __linux__
+#include <time.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+#ifdef USE_STACK_PAINT
+#include "StackPaint.h"
+#endif
+
+#ifdef USE_STACK_BOUNDS
+#include "StackBounds.h"
+#endif
+
+#ifdef USE_SAFE_READ
+#include "SafeRead.h"
+#endif
+
+#if defined(USE_SHADOW_STACK) || defined(USE_FUNCTION_HISTORY)
+#include "ShadowStack.h"
+#endif
+
+#if defined(USE_MODULE_RELATIVE_STACK) && defined(__linux__)
+#include <link.h>
+#include <errno.h>
+#endif
+
+#ifdef USE_LINUX_SIGNALS
+#include <ucontext.h>
+#include <unistd.h>
+
+// A SIGSEGV faulting address within this many bytes of the stack pointer is
+// treated as a stack overflow
+#define STACK_OVERFLOW_RANGE    (64 * 1024)
+#endif
 
 #define SAVE_STACK_ADDRESS(idx) \
 	{ \
@@ -8,7 +52,7 @@
 	    if (frameAddr##idx != NULL) { \
 		    void* returnAddr##idx = __builtin_frame_address (idx); \
 		    if (returnAddr##idx != NULL) \
-			    _coreDumpData.ActiveCallStack[idx] = (INTEGER_TYPE)returnAddr##idx; \
+			    ACTIVE_CALL_STACK[idx] = (INTEGER_TYPE)returnAddr##idx; \
 		    else { \
 			    goto stack_save_complete; \
 		    } \
@@ -18,6 +62,12 @@
 	    } \
     }
 
+#if defined(_MSC_VER)
+#define NO_INLINE __declspec(noinline)
+#else
+#define NO_INLINE __attribute__((noinline))
+#endif
+
 // Core dump data stored in RAM.
 // TODO: This data structure must not be zero-initialized at startup!
 // The data stored here must persist through a CPU reset. Platform-specific 
@@ -27,9 +77,295 @@
 // bootloader is used, the bootloader application must also not initialize this data. 
 // In short, the bootload and main application must agree upon a non zero-initialized
 // section to hold the CoreDumpData below.
+#ifdef USE_FAST_BOOT
+// Double-buffered core dump slots. A fault is stored into the write slot. At
+// boot, slots holding a core dump are handed to deferred persistence and the
+// write slot moves to a free slot, so a new fault during persistence cannot 
+// overwrite an unpersisted core dump.
+static CoreDumpData _coreDumpSlots[CORE_DUMP_SLOT_CNT];
+
+// Boot header. A single cache line read at boot detects stored core dumps.
+struct alignas(64) CoreDumpBootHeader
+{
+    uint32_t Key;                       // KEY_CORE_DUMP_STORED once initialized
+    uint32_t NotKey;
+    uint32_t WriteSlot;                 // Slot the next fault is stored into
+    std::atomic<uint32_t> PendingMask;  // Bit N set if slot N holds an unpersisted core dump
+};
+static_assert(sizeof(CoreDumpBootHeader) == 64, "Boot header must fill one cache line");
+
+// Must be placed within the same non zero-initialized section as the slots
+static CoreDumpBootHeader _bootHeader;
+
+static CoreDumpBootStats _bootStats;
+static uint64_t _bootDetectTime;
+
+// The boot header is not initialized at a cold boot; keep the index in range
+#define WRITE_SLOT          (_bootHeader.WriteSlot % CORE_DUMP_SLOT_CNT)
+
+// The slot written by the store in progress. Latched once by BeginStore() so
+// CoreDumpSlotRelease() moving the write slot cannot split a core dump 
+// across two slots. Normal zero-initialized RAM.
+static uint32_t _storeSlot = 0;
+#define _coreDumpData       _coreDumpSlots[_storeSlot]
+#define _writeSlotData      _coreDumpSlots[WRITE_SLOT]
+#else
 static CoreDumpData _coreDumpData;
+#define _writeSlotData      _coreDumpData
+#endif
 
-#ifdef USE_BUILTIN_BACKTRACE
+#ifdef USE_MODULE_RELATIVE_STACK
+// Absolute active call stack addresses. Encoded as module relative offsets 
+// into _coreDumpData after capture. Normal RAM.
+static INTEGER_TYPE _activeCallStack[CALL_STACK_SIZE];
+#define ACTIVE_CALL_STACK   _activeCallStack
+#else
+#define ACTIVE_CALL_STACK   _coreDumpData.ActiveCallStack
+#endif
+
+#ifdef USE_ECC_STORAGE
+// Check bytes protecting _coreDumpData. Must be placed within the same 
+// non zero-initialized section as _coreDumpData.
+#ifdef USE_FAST_BOOT
+static uint8_t _coreDumpEccSlots[CORE_DUMP_SLOT_CNT][ECC_CHECK_SIZE(sizeof(CoreDumpData))];
+#define _coreDumpEcc        _coreDumpEccSlots[_storeSlot]
+#define _writeSlotEcc       _coreDumpEccSlots[WRITE_SLOT]
+#else
+static uint8_t _coreDumpEcc[ECC_CHECK_SIZE(sizeof(CoreDumpData))];
+#define _writeSlotEcc       _coreDumpEcc
+#endif
+
+static_assert(offsetof(CoreDumpData, Key) == 0 && offsetof(CoreDumpData, NotKey) == 4,
+    "Key and NotKey must share the first ECC word");
+#endif
+
+// Clock calibration copied into each core dump. Double-buffered so a fault
+// during CoreDumpClockCalibrate() copies a complete calibration.
+static CoreDumpClockCalibration _clockCalibration[2];
+static std::atomic<uint32_t> _clockCalibrationIdx(0);
+
+#if !defined(__aarch64__)
+// The first calibration. The cycle counter frequency is measured from it.
+static CoreDumpClockCalibration _clockBase;
+#endif
+
+// True while a core dump is being stored. A nested fault within the core dump
+// code must not overwrite the first fault. Normal zero-initialized RAM.
+static std::atomic<bool> _coreDumpStoring(false);
+
+// Site id of a core dump not caused by an assertion (see AssertSite.h)
+#ifndef USE_ASSERT_SITES
+#define ASSERT_SITE_NONE    0xFFFF
+#endif
+
+// Read the free running cycle counter. A few cycles; async-signal-safe.
+static inline uint64_t ReadCycleCounter()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#elif defined(USE_HARDWARE)
+    // TODO: Enable the DWT cycle counter at startup. Platform specific detail.
+    return DWT->CYCCNT;
+#else
+    return 0;
+#endif
+}
+
+// Read CLOCK_MONOTONIC in nanoseconds. Async-signal-safe.
+static uint64_t ReadMonotonicNs()
+{
+#ifdef __linux__
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+#else
+    // TODO: Read a free running hardware timer
+    return 0;
+#endif
+}
+
+#ifdef USE_MEMORY_REGIONS
+// A memory region registered for storage within the core dump
+struct MemoryRegion
+{
+    const char* name;
+    const void* address;
+    uint32_t length;
+};
+
+// Registered memory regions. Normal zero-initialized RAM; register at startup.
+static MemoryRegion _memoryRegions[MAX_MEMORY_REGIONS];
+static int _memoryRegionCnt = 0;
+
+// Copy a memory region into the core dump region blob. The region is truncated
+// if the blob is full. 
+static void StoreMemoryRegion(const char* name, const void* address, uint32_t length)
+{
+    if (_coreDumpData.RegionCount >= MAX_STORED_REGIONS || address == NULL)
+        return;
+
+    // Keep each region INTEGER_TYPE aligned within the blob
+    uint32_t offset = (_coreDumpData.RegionBlobUsed + sizeof(INTEGER_TYPE) - 1) &
+        ~(uint32_t)(sizeof(INTEGER_TYPE) - 1);
+    if (offset >= MEMORY_REGION_BLOB_SIZE)
+        return;
+    if (length > MEMORY_REGION_BLOB_SIZE - offset)
+        length = MEMORY_REGION_BLOB_SIZE - offset;
+
+#ifdef USE_SAFE_READ
+    // Store only the readable part of the region
+    length = (uint32_t)SafeReadExtent(address, length);
+#endif
+
+    CoreDumpRegion* region = &_coreDumpData.Regions[_coreDumpData.RegionCount++];
+    strncpy(region->Name, name, REGION_NAME_LEN);
+    region->Name[REGION_NAME_LEN - 1] = 0;
+    region->Address = (INTEGER_TYPE)address;
+    region->Offset = offset;
+    region->Length = length;
+
+    memcpy(&_coreDumpData.RegionBlob[offset], address, length);
+    _coreDumpData.RegionBlobUsed = offset + length;
+}
+
+#ifdef USE_HARDWARE
+// Store the memory surrounding a faulting address, if the address is valid
+static void StoreFaultAddressRegion(const char* name, uint32_t address)
+{
+    uint32_t begin = address - FAULT_ADDRESS_REGION_SIZE / 2;
+    uint32_t end = begin + FAULT_ADDRESS_REGION_SIZE - 1;
+
+    // Only read memory known to exist; a bad address causes a nested fault
+    if ((begin >= RAM_BEGIN && end <= RAM_END) ||
+        (begin >= FLASH_BASE && end <= FLASH_END))
+    {
+        StoreMemoryRegion(name, (const void*)begin, FAULT_ADDRESS_REGION_SIZE);
+    }
+}
+#elif defined(USE_LINUX_SIGNALS) && defined(USE_SAFE_READ)
+// Store the readable memory surrounding a faulting address. The address 
+// itself is often unmapped while the memory before or after it is not.
+static void StoreFaultAddressRegion(const char* name, uint64_t address)
+{
+    if (address == 0)
+        return;
+    uintptr_t begin = (uintptr_t)address - FAULT_ADDRESS_REGION_SIZE / 2;
+    if (begin > (uintptr_t)address)
+        begin = 0;
+    uintptr_t end = begin + FAULT_ADDRESS_REGION_SIZE;
+
+    // Skip unreadable leading pages; StoreMemoryRegion() stops at the first
+    // unreadable byte after them
+    while (begin < end && SafeReadExtent((const void*)begin, 1) == 0)
+        begin = (begin + SAFE_READ_PAGE_SIZE) & ~(uintptr_t)(SAFE_READ_PAGE_SIZE - 1);
+    if (begin < end)
+        StoreMemoryRegion(name, (const void*)begin, (uint32_t)(end - begin));
+}
+#endif
+
+// Store all registered memory regions, the active stack top and memory 
+// surrounding any faulting addresses into the core dump
+static void StoreMemoryRegions(INTEGER_TYPE* stackPointer)
+{
+    _coreDumpData.RegionCount = 0;
+    _coreDumpData.RegionBlobUsed = 0;
+
+    for (int r = 0; r < _memoryRegionCnt; r++)
+        StoreMemoryRegion(_memoryRegions[r].name, _memoryRegions[r].address, _memoryRegions[r].length);
+
+#if !defined(USE_HARDWARE) && defined(__GNUC__)
+    // No stack pointer register access; use this function's frame instead
+    if (stackPointer == 0)
+        stackPointer = (INTEGER_TYPE*)__builtin_frame_address(0);
+#endif
+
+#ifdef USE_HARDWARE
+    if (stackPointer >= (INTEGER_TYPE*)RAM_BEGIN && stackPointer <= (INTEGER_TYPE*)RAM_END)
+    {
+        uint32_t length = STACK_REGION_SIZE;
+        if ((uint32_t)stackPointer + length - 1 > RAM_END)
+            length = RAM_END - (uint32_t)stackPointer + 1;
+        StoreMemoryRegion("stack", stackPointer, length);
+    }
+
+    // Store memory around addresses held within the exception stack frame registers
+    if (_coreDumpData.Type == FAULT_EXCEPTION)
+    {
+        StoreFaultAddressRegion("R0", _coreDumpData.R0_register);
+        StoreFaultAddressRegion("R1", _coreDumpData.R1_register);
+        StoreFaultAddressRegion("R2", _coreDumpData.R2_register);
+        StoreFaultAddressRegion("R3", _coreDumpData.R3_register);
+        StoreFaultAddressRegion("LR", _coreDumpData.LR_register);
+    }
+#elif defined(USE_STACK_BOUNDS)
+    StoreMemoryRegion("stack", stackPointer, StackBoundsClamp(stackPointer, STACK_REGION_SIZE));
+#else
+    StoreMemoryRegion("stack", stackPointer, STACK_REGION_SIZE);
+#endif
+
+#if defined(USE_LINUX_SIGNALS) && defined(USE_SAFE_READ) && !defined(USE_HARDWARE)
+    // Store memory around the address of a memory access or instruction fault.
+    // For other signals si_addr is not an address.
+    int signalNumber = _coreDumpData.SignalNumber;
+    if (signalNumber == SIGSEGV || signalNumber == SIGBUS || signalNumber == SIGILL || signalNumber == SIGFPE)
+        StoreFaultAddressRegion("si_addr", _coreDumpData.SignalAddress);
+#endif
+}
+
+bool CoreDumpRegisterRegion(const char* name, const void* address, uint32_t length)
+{
+    if (_memoryRegionCnt >= MAX_MEMORY_REGIONS || name == NULL || address == NULL)
+        return false;
+
+    _memoryRegions[_memoryRegionCnt].name = name;
+    _memoryRegions[_memoryRegionCnt].address = address;
+    _memoryRegions[_memoryRegionCnt].length = length;
+    _memoryRegionCnt++;
+    return true;
+}
+
+const CoreDumpRegion* CoreDumpFindRegion(const CoreDumpData* coreDumpData, const char* name)
+{
+    uint32_t count = coreDumpData->RegionCount;
+    if (count > MAX_STORED_REGIONS)
+        count = MAX_STORED_REGIONS;
+
+    for (uint32_t r = 0; r < count; r++)
+    {
+        if (strncmp(coreDumpData->Regions[r].Name, name, REGION_NAME_LEN) == 0)
+            return &coreDumpData->Regions[r];
+    }
+    return NULL;
+}
+#endif
+
+#if defined(USE_BUILTIN_BACKTRACE) && defined(USE_SAFE_READ) && \
+    (defined(__x86_64__) || defined(__aarch64__))
+// Store active call stack by walking the frame pointer chain. Each frame 
+// record is read using SafeRead() so a corrupt frame pointer ends the walk
+// instead of causing a nested fault. Requires -fno-omit-frame-pointer.
+static NO_INLINE void SaveActiveCallStack(void)
+{
+    INTEGER_TYPE frame = (INTEGER_TYPE)__builtin_frame_address(0);
+    for (int idx = 0; idx < CALL_STACK_SIZE && frame != 0; idx++)
+    {
+        // Frame record: the caller frame pointer then the return address
+        INTEGER_TYPE record[2];
+        if (!SafeRead(record, (const void*)frame, sizeof(record)) || record[1] == 0)
+            break;
+        ACTIVE_CALL_STACK[idx] = record[1];
+
+        // Caller frames are always closer to the stack base
+        if (record[0] <= frame)
+            break;
+        frame = record[0];
+    }
+}
+#elif defined(USE_BUILTIN_BACKTRACE)
 // Store active call stack using GCC __builtin_frame_address()
 static void SaveActiveCallStack(void)
 {
@@ -50,38 +386,18 @@ stack_save_complete:
 
 #ifdef USE_LINUX_BACKTRACE
 #include <execinfo.h>
-#include <cstdlib>
-#include <iostream>
 
+// Called from the fatal signal handler; no allocation or stdio. Symbols are 
+// resolved offline by the decoder.
 static void SaveActiveCallStack(int depth)
 {
     void* callStack[CALL_STACK_SIZE];
+    if (depth > CALL_STACK_SIZE)
+        depth = CALL_STACK_SIZE;
     int frames = backtrace(callStack, depth);
 
-    if (frames <= 0) 
-    {
-        std::cerr << "Failed to retrieve call stack." << std::endl;
-        return;
-    }
-
-    char** symbols = backtrace_symbols(callStack, frames);
-    if (symbols == nullptr) 
-    {
-        std::cerr << "Failed to retrieve call stack symbols." << std::endl;
-        return;
-    }
-
-    // Only save up to CALL_STACK_SIZE addresses.
-    int saveCount = std::min(CALL_STACK_SIZE, frames);
-
-    for (int i = 0; i < saveCount; ++i) 
-    {
-        _coreDumpData.ActiveCallStack[i] = reinterpret_cast<INTEGER_TYPE>(callStack[i]);
-        // Optionally, you can print the function names using symbols[i]
-        // std::cout << symbols[i] << std::endl;
-    }
-
-    free(symbols);
+    for (int i = 0; i < frames; ++i) 
+        ACTIVE_CALL_STACK[i] = reinterpret_cast<INTEGER_TYPE>(callStack[i]);
 }
 #endif
 
@@ -114,7 +430,7 @@ static void SaveActiveCallStack(int depth)
 
     for (int i = 0; i < saveCount; ++i) 
     {
-        _coreDumpData.ActiveCallStack[i] = reinterpret_cast<INTEGER_TYPE>(callStack[i]);
+        ACTIVE_CALL_STACK[i] = reinterpret_cast<INTEGER_TYPE>(callStack[i]);
         // Optionally, you can store the function names instead of function addresses
         // using SymFromAddr
     }
@@ -129,23 +445,52 @@ static void StoreCallStack(INTEGER_TYPE* stackPointer, INTEGER_TYPE* stackStoreA
 {
     int stackDepth = 0;
     int depth = 0;
+    int maxDepth = MAX_STACK_DEPTH_SEARCH;
+    bool bounded = false;
 
     // Clear the core dump call stack storage
-    memset(stackStoreArr, 0, sizeof(uint32_t) * stackStoreArrLen);
+    memset(stackStoreArr, 0, sizeof(INTEGER_TYPE) * stackStoreArrLen);
 
-    // Ensure the stack pointer is within RAM address range
-    if (stackPointer < (INTEGER_TYPE*)RAM_BEGIN || stackPointer > (INTEGER_TYPE*)RAM_END)
-        return;
+#if defined(USE_STACK_BOUNDS) && !defined(USE_HARDWARE) && defined(__GNUC__)
+    // No stack pointer register access; use this function's frame instead
+    if (stackPointer == 0)
+        stackPointer = (INTEGER_TYPE*)__builtin_frame_address(0);
+#endif
+
+#ifdef USE_STACK_BOUNDS
+    // Search no further than the registered stack base. No stack marker needed.
+    uintptr_t stackLow, stackHigh;
+    if (StackBoundsFind(stackPointer, &stackLow, &stackHigh))
+    {
+        bounded = true;
+        uintptr_t words = (stackHigh - (uintptr_t)stackPointer) / sizeof(INTEGER_TYPE);
+        if (words < (uintptr_t)maxDepth)
+            maxDepth = (int)words;
+    }
+    else
+#endif
+    {
+        // Ensure the stack pointer is within RAM address range
+        if (stackPointer < (INTEGER_TYPE*)RAM_BEGIN || stackPointer > (INTEGER_TYPE*)RAM_END)
+            return;
+    }
+
+#ifdef USE_SAFE_READ
+    // Search no further than the readable memory. A corrupt stack pointer 
+    // must not cause a nested fault.
+    maxDepth = (int)(SafeReadExtent(stackPointer, maxDepth * sizeof(INTEGER_TYPE)) / sizeof(INTEGER_TYPE));
+#endif
 
     // Search the stack for address values within the flash address range. 
     // We're looking for stored LR (link register) values pushed onto the stack.
-    for (depth = 0; depth < MAX_STACK_DEPTH_SEARCH; depth++)
+    for (depth = 0; depth < maxDepth; depth++)
     {
         // Get a integer value from the stack
         INTEGER_TYPE stackData = *(stackPointer + depth);
 
         // Have we reached the beginning of the stack?
-        if (stackData == STACK_MARKER && *(stackPointer + depth + 1) == STACK_MARKER)
+        if (!bounded && depth + 1 < maxDepth && stackData == STACK_MARKER && 
+            *(stackPointer + depth + 1) == STACK_MARKER)
             break;
 
         // Is the stack value within the flash address range? This is the 
@@ -164,6 +509,293 @@ static void StoreCallStack(INTEGER_TYPE* stackPointer, INTEGER_TYPE* stackStoreA
     }
 }
 
+#ifdef USE_STACK_SLICE
+// Store the registers required to start an offline unwind and a raw window of 
+// the stack. Registers captured here are consistent with this function's 
+// instruction address, so the decoder unwinds starting within this function.
+static NO_INLINE void StoreStackSlice(INTEGER_TYPE* stackPointer)
+{
+    INTEGER_TYPE* regs = _coreDumpData.StackSliceRegisters;
+    uint64_t mask = 0;
+    uint32_t length = STACK_SLICE_SIZE;
+
+    memset(regs, 0, sizeof(_coreDumpData.StackSliceRegisters));
+
+    if (stackPointer != 0)
+    {
+#if defined(USE_SIGNAL_REGISTERS) && defined(__x86_64__)
+        // Faulting registers stored by CoreDumpStoreSignal()
+        const CoreDumpX86_64Registers* fault = &_coreDumpData.Registers;
+        regs[0] = fault->RAX;
+        regs[1] = fault->RDX;
+        regs[2] = fault->RCX;
+        regs[3] = fault->RBX;
+        regs[4] = fault->RSI;
+        regs[5] = fault->RDI;
+        regs[6] = fault->RBP;
+        regs[7] = fault->RSP;
+        regs[8] = fault->R8;
+        regs[9] = fault->R9;
+        regs[10] = fault->R10;
+        regs[11] = fault->R11;
+        regs[12] = fault->R12;
+        regs[13] = fault->R13;
+        regs[14] = fault->R14;
+        regs[15] = fault->R15;
+        regs[16] = fault->RIP;
+        mask = (1ull << UNWIND_REGISTER_CNT) - 1;
+#elif defined(USE_SIGNAL_REGISTERS) && defined(__aarch64__)
+        // Faulting registers stored by CoreDumpStoreSignal()
+        const CoreDumpAArch64Registers* fault = &_coreDumpData.Registers;
+        for (int r = 0; r < 31; r++)
+            regs[r] = fault->X[r];
+        regs[31] = fault->SP;
+        regs[32] = fault->PC;
+        mask = (1ull << UNWIND_REGISTER_CNT) - 1;
+#elif defined(USE_HARDWARE)
+        // Registers pushed onto the stack by the CPU upon exception entry.
+        // TODO: R4-R11 are not stacked by the CPU. Store on handler entry if required.
+        regs[0] = *stackPointer;
+        regs[1] = *(stackPointer + 1);
+        regs[2] = *(stackPointer + 2);
+        regs[3] = *(stackPointer + 3);
+        regs[12] = *(stackPointer + 4);
+        regs[14] = *(stackPointer + 5);
+        regs[15] = *(stackPointer + 6);
+        regs[13] = (INTEGER_TYPE)(stackPointer + 8);
+        mask = 0xF | (1 << 12) | (1 << 13) | (1 << 14) | (1 << 15);
+#endif
+    }
+    else
+    {
+#if defined(__GNUC__) && defined(__x86_64__)
+        __asm__ volatile(
+            "leaq 0(%%rip), %%rax\n\t"
+            "movq %%rax, 128(%0)\n\t"
+            "movq %%rbx, 24(%0)\n\t"
+            "movq %%rbp, 48(%0)\n\t"
+            "movq %%rsp, 56(%0)\n\t"
+            "movq %%r12, 96(%0)\n\t"
+            "movq %%r13, 104(%0)\n\t"
+            "movq %%r14, 112(%0)\n\t"
+            "movq %%r15, 120(%0)\n\t"
+            : : "r"(regs) : "rax", "memory");
+        mask = (1 << 3) | (1 << 6) | (1 << 7) | (0xFull << 12) | (1 << 16);
+#elif defined(__GNUC__) && defined(__aarch64__)
+        __asm__ volatile(
+            "adr x9, .\n\t"
+            "str x9, [%0, #256]\n\t"
+            "stp x19, x20, [%0, #152]\n\t"
+            "stp x21, x22, [%0, #168]\n\t"
+            "stp x23, x24, [%0, #184]\n\t"
+            "stp x25, x26, [%0, #200]\n\t"
+            "stp x27, x28, [%0, #216]\n\t"
+            "stp x29, x30, [%0, #232]\n\t"
+            "mov x9, sp\n\t"
+            "str x9, [%0, #248]\n\t"
+            : : "r"(regs) : "x9", "memory");
+        mask = (0x3FFFull << 19) | (1ull << 32);
+#elif defined(__GNUC__)
+        // TODO: Capture the PC and callee-saved registers for this architecture
+        regs[UNWIND_REGISTER_SP] = (INTEGER_TYPE)__builtin_frame_address(0);
+        mask = 1ull << UNWIND_REGISTER_SP;
+#else
+        // Approximate the stack pointer using a local variable address
+        INTEGER_TYPE local = 0;
+        regs[UNWIND_REGISTER_SP] = (INTEGER_TYPE)&local;
+        mask = 1ull << UNWIND_REGISTER_SP;
+#endif
+    }
+
+    // A fault stack pointer may be above the faulting SP register, e.g. a 
+    // stack overflow fault SP is within the guard page
+    INTEGER_TYPE sliceBegin = stackPointer != 0 ? (INTEGER_TYPE)stackPointer : regs[UNWIND_REGISTER_SP];
+
+    _coreDumpData.StackSliceRegisterMask = mask;
+    _coreDumpData.StackSliceAddress = sliceBegin;
+    _coreDumpData.StackSliceLength = 0;
+
+    if (sliceBegin == 0)
+        return;
+
+#ifdef USE_HARDWARE
+    // Ensure the stack window is within RAM address range
+    if (sliceBegin < RAM_BEGIN || sliceBegin > RAM_END)
+        return;
+    if (sliceBegin + length - 1 > RAM_END)
+        length = RAM_END - sliceBegin + 1;
+#endif
+
+#ifdef USE_STACK_BOUNDS
+    // Don't copy beyond the stack base
+    length = StackBoundsClamp((const void*)sliceBegin, length);
+#endif
+
+#ifdef USE_SAFE_READ
+    // The faulting stack pointer may be corrupt
+    length = (uint32_t)SafeReadExtent((const void*)sliceBegin, length);
+#endif
+
+    // Copy the raw stack window. The decoder rebuilds frames from it offline.
+    memcpy(_coreDumpData.StackSlice, (const void*)sliceBegin, length);
+    _coreDumpData.StackSliceLength = length;
+}
+#endif
+
+#ifdef USE_MODULE_RELATIVE_STACK
+// A loaded module and its executable address range
+struct LoadedModule
+{
+    uintptr_t Begin;
+    uintptr_t End;
+    CoreDumpModule Module;
+};
+
+// Loaded module table. Normal RAM; rebuilt by CoreDumpModulesInit().
+static LoadedModule _loadedModules[MAX_LOADED_MODULES];
+static int _loadedModuleCnt = 0;
+
+#ifdef __linux__
+// Copy the GNU build-id from a PT_NOTE segment, if present
+static void ReadBuildId(const uint8_t* note, size_t size, CoreDumpModule* module)
+{
+    const uint8_t* end = note + size;
+    while (note + 12 <= end)
+    {
+        uint32_t nameSize, descSize, type;
+        memcpy(&nameSize, note, 4);
+        memcpy(&descSize, note + 4, 4);
+        memcpy(&type, note + 8, 4);
+
+        const uint8_t* name = note + 12;
+        const uint8_t* desc = name + ((nameSize + 3) & ~3u);
+        const uint8_t* next = desc + ((descSize + 3) & ~3u);
+        if (next > end)
+            break;
+
+        if (type == NT_GNU_BUILD_ID && nameSize == 4 && memcmp(name, "GNU", 4) == 0)
+        {
+            module->BuildIdLength = descSize < BUILD_ID_LEN ? descSize : BUILD_ID_LEN;
+            memcpy(module->BuildId, desc, module->BuildIdLength);
+            return;
+        }
+        note = next;
+    }
+}
+
+// dl_iterate_phdr() callback adding one module to the loaded module table
+static int AddLoadedModule(struct dl_phdr_info* info, size_t size, void* data)
+{
+    (void)size;
+    (void)data;
+    if (_loadedModuleCnt >= MAX_LOADED_MODULES)
+        return 1;
+
+    LoadedModule* loaded = &_loadedModules[_loadedModuleCnt];
+    memset(loaded, 0, sizeof(*loaded));
+
+    uintptr_t begin = UINTPTR_MAX;
+    uintptr_t end = 0;
+    for (int p = 0; p < info->dlpi_phnum; p++)
+    {
+        const ElfW(Phdr)* phdr = &info->dlpi_phdr[p];
+        uintptr_t address = info->dlpi_addr + phdr->p_vaddr;
+        if (phdr->p_type == PT_LOAD && (phdr->p_flags & PF_X))
+        {
+            if (address < begin)
+                begin = address;
+            if (address + phdr->p_memsz > end)
+                end = address + phdr->p_memsz;
+        }
+        else if (phdr->p_type == PT_NOTE)
+        {
+            ReadBuildId((const uint8_t*)address, phdr->p_memsz, &loaded->Module);
+        }
+    }
+
+    // No executable code
+    if (begin >= end)
+        return 0;
+
+    // The main executable has no name
+    const char* path = info->dlpi_name[0] != 0 ? info->dlpi_name : program_invocation_short_name;
+    const char* name = strrchr(path, '/');
+    strncpy(loaded->Module.Name, name != NULL ? name + 1 : path, MODULE_NAME_LEN);
+    loaded->Module.Name[MODULE_NAME_LEN - 1] = 0;
+
+    loaded->Begin = begin;
+    loaded->End = end;
+    loaded->Module.LoadBase = info->dlpi_addr;
+    _loadedModuleCnt++;
+    return 0;
+}
+#endif
+
+int CoreDumpModulesInit()
+{
+    _loadedModuleCnt = 0;
+#ifdef __linux__
+    dl_iterate_phdr(AddLoadedModule, NULL);
+#else
+    // TODO: A single firmware image linked at its run address
+    LoadedModule* loaded = &_loadedModules[_loadedModuleCnt++];
+    memset(loaded, 0, sizeof(*loaded));
+    strncpy(loaded->Module.Name, "firmware", MODULE_NAME_LEN);
+    loaded->Begin = FLASH_BASE;
+    loaded->End = (uintptr_t)FLASH_END + 1;
+#endif
+    return _loadedModuleCnt;
+}
+
+// Encode the captured active call stack as module relative offsets and 
+// store the referenced modules
+static void StoreModuleRelativeStack()
+{
+    int storedModules[MAX_STACK_MODULES];
+
+    _coreDumpData.ModuleCount = 0;
+    memset(_coreDumpData.Modules, 0, sizeof(_coreDumpData.Modules));
+
+    for (int s = 0; s < CALL_STACK_SIZE; s++)
+    {
+        uintptr_t address = (uintptr_t)_activeCallStack[s];
+        uint8_t moduleIdx = STACK_MODULE_NONE;
+        uint32_t offset = (uint32_t)address;
+
+        for (int m = 0; m < _loadedModuleCnt && address != 0; m++)
+        {
+            const LoadedModule* loaded = &_loadedModules[m];
+            if (address < loaded->Begin || address >= loaded->End)
+                continue;
+
+            uint64_t linkAddress = address - loaded->Module.LoadBase;
+            if (linkAddress > UINT32_MAX)
+                break;
+
+            // Find or add the module within the core dump module table
+            uint32_t d = 0;
+            while (d < _coreDumpData.ModuleCount && storedModules[d] != m)
+                d++;
+            if (d == _coreDumpData.ModuleCount)
+            {
+                if (d >= MAX_STACK_MODULES)
+                    break;
+                storedModules[d] = m;
+                _coreDumpData.Modules[d] = loaded->Module;
+                _coreDumpData.ModuleCount++;
+            }
+
+            moduleIdx = (uint8_t)d;
+            offset = (uint32_t)linkAddress;
+            break;
+        }
+
+        _coreDumpData.ActiveCallStackModule[s] = moduleIdx;
+        _coreDumpData.ActiveCallStackOffset[s] = offset;
+    }
+}
+#endif
+
 // Store all thread call stacks into core dump 
 static void StoreThreadCallStacks()
 {
@@ -188,21 +820,56 @@ static void StoreThreadCallStacks()
         // Store the call stack for this task
         StoreCallStack(stackPointer, &_coreDumpData.ThreadCallStacks[taskCnt][0], CALL_STACK_SIZE);
 
+#ifdef USE_MEMORY_REGIONS
+        // Store the top of this task stack
+        if (stackPointer >= (INTEGER_TYPE*)RAM_BEGIN && stackPointer <= (INTEGER_TYPE*)RAM_END)
+        {
+            char name[] = "task0";
+            name[4] = (char)('0' + taskCnt % 10);
+            uint32_t length = STACK_REGION_SIZE;
+            if ((uint32_t)stackPointer + length - 1 > RAM_END)
+                length = RAM_END - (uint32_t)stackPointer + 1;
+            StoreMemoryRegion(name, stackPointer, length);
+        }
+#endif
+
         if (++taskCnt >= CRASH_DUMP_TASK_SIZE)
             break;
     }
 #endif
 }
 
-// Store core dump data into RAM
-void CoreDumpStore(INTEGER_TYPE* stackPointer, const char* fileName,
-    uint32_t lineNumber, uint32_t auxCode)
+static bool IsSlotSaved(const CoreDumpData* coreDumpData);
+
+// Claim the core dump for a store. Returns false if a core dump is already 
+// stored or being stored; the first core dump is what is needed, not any 
+// subsequent crashes detected after the first one.
+static bool BeginStore()
 {
-    // Is a core dump already stored? Then don't overwrite. The first  
-    // core dump is what is needed, not any subsequent crashes detected
-    // after the first one.
-    if (IsCoreDumpSaved())
-        return;
+    if (_coreDumpStoring.exchange(true))
+        return false;
+
+#ifdef USE_FAST_BOOT
+    // Every later access of the store uses this slot
+    _storeSlot = WRITE_SLOT;
+#endif
+    if (IsSlotSaved(&_coreDumpData))
+    {
+        _coreDumpStoring = false;
+        return false;
+    }
+    return true;
+}
+
+// Store core dump data into RAM. The caller claims the store with 
+// BeginStore().
+static void StoreCoreDump(INTEGER_TYPE* stackPointer, const char* fileName,
+    uint32_t lineNumber, uint32_t auxCode, uint16_t assertSiteId)
+{
+    // Timestamp the fault first
+    _coreDumpData.CycleCount = ReadCycleCounter();
+    _coreDumpData.MonotonicNs = ReadMonotonicNs();
+    _coreDumpData.Clock = _clockCalibration[_clockCalibrationIdx.load(std::memory_order_acquire) & 1];
 
     // Set the key indicating a core dump is stored 
     _coreDumpData.Key = KEY_CORE_DUMP_STORED;
@@ -248,15 +915,30 @@ void CoreDumpStore(INTEGER_TYPE* stackPointer, const char* fileName,
     {
         // Software assertion occurred!
         _coreDumpData.Type = SOFTWARE_ASSERTION;
+
+#ifdef USE_LINUX_SIGNALS
+        _coreDumpData.SignalNumber = 0;
+        _coreDumpData.SignalCode = 0;
+        _coreDumpData.SignalAddress = 0;
+#endif
+#ifdef USE_SIGNAL_REGISTERS
+        memset(&_coreDumpData.Registers, 0, sizeof(_coreDumpData.Registers));
+#endif
     }
 
-    // Save file name and line number
+    // Save file name (or assertion site) and line number
     _coreDumpData.LineNumber = lineNumber;
+#ifdef USE_ASSERT_SITES
+    _coreDumpData.AssertSiteId = assertSiteId;
+    (void)fileName;
+#else
+    (void)assertSiteId;
     if (fileName != NULL)
     {
         strncpy(_coreDumpData.FileName, fileName, FILE_NAME_LEN);
         _coreDumpData.FileName[FILE_NAME_LEN - 1] = 0;
     }
+#endif
 
     // Get the stack pointer if none passed in
     if (stackPointer == 0)
@@ -269,32 +951,398 @@ void CoreDumpStore(INTEGER_TYPE* stackPointer, const char* fileName,
 #endif
     }
 
+#ifdef USE_STACK_SLICE
+    // Save the raw stack window and unwind registers
+    StoreStackSlice(stackPointer);
+#endif
+
     // Save the current call stack
+#ifdef USE_MODULE_RELATIVE_STACK
+    memset(_activeCallStack, 0, sizeof(_activeCallStack));
+#endif
+#ifdef USE_SHADOW_STACK
+    // Copy the shadow stack if an instrumented function is active; no unwind
+    if (ShadowStackCopy(ACTIVE_CALL_STACK, CALL_STACK_SIZE) == 0)
+#endif
 #ifdef USE_BUILTIN_BACKTRACE
     SaveActiveCallStack();
 #elif defined(USE_LINUX_BACKTRACE) || defined(USE_WINDOWS_BACKTRACE)
+#ifdef USE_SAFE_READ
+    // The unwinder reads the faulting stack without validation. Skip the
+    // call stack if the faulting stack pointer is corrupt.
+    if (stackPointer == 0 || SafeReadExtent(stackPointer, sizeof(INTEGER_TYPE)) != 0)
+#endif
     SaveActiveCallStack(CALL_STACK_SIZE);
 #else
-    StoreCallStack(stackPointer, &_coreDumpData.ActiveCallStack[0], CALL_STACK_SIZE);
+    StoreCallStack(stackPointer, &ACTIVE_CALL_STACK[0], CALL_STACK_SIZE);
+#endif
+
+#ifdef USE_MODULE_RELATIVE_STACK
+    StoreModuleRelativeStack();
+#endif
+
+#ifdef USE_FUNCTION_HISTORY
+    // Save the functions entered before the fault, including those returned from
+    _coreDumpData.FunctionHistoryBase = FunctionHistoryBase();
+    _coreDumpData.FunctionHistoryCount = FunctionHistoryCopy(_coreDumpData.FunctionHistory, FUNCTION_HISTORY_SIZE);
+#endif
+
+#ifdef USE_MEMORY_REGIONS
+    // Save registered memory regions, active stack top and faulting address memory
+    StoreMemoryRegions(stackPointer);
+#endif
+
+    // Save the call stacks of all other threads
+    StoreThreadCallStacks();
+
+#ifdef USE_STACK_PAINT
+    // Save the peak usage of each painted stack
+    _coreDumpData.StackUsageCount = StackPaintGetAllUsage(_coreDumpData.StackUsage, MAX_PAINTED_STACKS);
+#endif
+
+    // Compute the CRC last. A partially written core dump fails validation.
+    _coreDumpData.Crc = CoreDumpCrc(&_coreDumpData);
+
+#ifdef USE_ECC_STORAGE
+    // Encode the check bytes after the core dump is complete
+    EccEncode(&_coreDumpData, sizeof(_coreDumpData), _coreDumpEcc);
+#endif
+
+#ifdef USE_FAST_BOOT
+    // Publish the stored slot for boot detection
+    _bootHeader.PendingMask.fetch_or(1u << _storeSlot);
 #endif
 }
 
-bool IsCoreDumpSaved()
+void CoreDumpStore(INTEGER_TYPE* stackPointer, const char* fileName,
+    uint32_t lineNumber, uint32_t auxCode)
+{
+    if (BeginStore())
+        StoreCoreDump(stackPointer, fileName, lineNumber, auxCode, ASSERT_SITE_NONE);
+}
+
+#ifdef USE_ASSERT_SITES
+void CoreDumpStoreAssert(const AssertSite* site, uint32_t auxCode)
+{
+    if (BeginStore())
+        StoreCoreDump(0, site->File, site->Line, auxCode, AssertSiteId(site));
+}
+#endif
+
+#ifdef USE_LINUX_SIGNALS
+// The page size, cached by CoreDumpSignalInit(). sysconf() is not 
+// async-signal-safe.
+static uintptr_t _pageSize = 4096;
+
+void CoreDumpSignalInit()
+{
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pageSize > 0)
+        _pageSize = (uintptr_t)pageSize;
+
+#ifdef USE_LINUX_BACKTRACE
+    // The first backtrace() call loads libgcc, which allocates
+    void* warmUp[1];
+    backtrace(warmUp, 1);
+#endif
+}
+
+// Store fatal signal core dump data into RAM
+void CoreDumpStoreSignal(int signalNumber, const siginfo_t* signalInfo, const void* userContext,
+    const char* fileName, uint32_t lineNumber)
 {
-    if (_coreDumpData.Key == KEY_CORE_DUMP_STORED &&
-        _coreDumpData.NotKey == ~KEY_CORE_DUMP_STORED)
+    // Is a core dump already stored? Then don't overwrite.
+    if (!BeginStore())
+        return;
+
+    const ucontext_t* context = (const ucontext_t*)userContext;
+    INTEGER_TYPE* stackPointer = 0;
+
+    _coreDumpData.SignalNumber = signalNumber;
+    _coreDumpData.SignalCode = signalInfo != NULL ? signalInfo->si_code : 0;
+    _coreDumpData.SignalAddress = signalInfo != NULL ? (uint64_t)signalInfo->si_addr : 0;
+#ifdef USE_SIGNAL_REGISTERS
+    memset(&_coreDumpData.Registers, 0, sizeof(_coreDumpData.Registers));
+#endif
+
+    if (context != NULL)
+    {
+#if defined(__x86_64__)
+        // Store the registers saved by the kernel upon signal delivery
+        const greg_t* gregs = context->uc_mcontext.gregs;
+        CoreDumpX86_64Registers* regs = &_coreDumpData.Registers;
+        regs->RAX = gregs[REG_RAX];
+        regs->RBX = gregs[REG_RBX];
+        regs->RCX = gregs[REG_RCX];
+        regs->RDX = gregs[REG_RDX];
+        regs->RSI = gregs[REG_RSI];
+        regs->RDI = gregs[REG_RDI];
+        regs->RBP = gregs[REG_RBP];
+        regs->RSP = gregs[REG_RSP];
+        regs->R8 = gregs[REG_R8];
+        regs->R9 = gregs[REG_R9];
+        regs->R10 = gregs[REG_R10];
+        regs->R11 = gregs[REG_R11];
+        regs->R12 = gregs[REG_R12];
+        regs->R13 = gregs[REG_R13];
+        regs->R14 = gregs[REG_R14];
+        regs->R15 = gregs[REG_R15];
+        regs->RIP = gregs[REG_RIP];
+        regs->EFLAGS = gregs[REG_EFL];
+        regs->ERR = gregs[REG_ERR];
+        regs->TRAPNO = gregs[REG_TRAPNO];
+        regs->CR2 = gregs[REG_CR2];
+        stackPointer = (INTEGER_TYPE*)regs->RSP;
+#elif defined(__aarch64__)
+        // Store the registers saved by the kernel upon signal delivery
+        CoreDumpAArch64Registers* regs = &_coreDumpData.Registers;
+        for (int r = 0; r < 31; r++)
+            regs->X[r] = context->uc_mcontext.regs[r];
+        regs->SP = context->uc_mcontext.sp;
+        regs->PC = context->uc_mcontext.pc;
+        regs->PSTATE = context->uc_mcontext.pstate;
+        regs->FAR = context->uc_mcontext.fault_address;
+
+        // The ESR is stored in an esr_context record within the reserved area.
+        // Each record starts with a 32-bit magic and 32-bit size.
+        const uint8_t* reserved = (const uint8_t*)context->uc_mcontext.__reserved;
+        size_t offset = 0;
+        while (offset + 16 <= sizeof(context->uc_mcontext.__reserved))
+        {
+            uint32_t magic, size;
+            memcpy(&magic, reserved + offset, sizeof(magic));
+            memcpy(&size, reserved + offset + 4, sizeof(size));
+            if (magic == 0 || size < 8)
+                break;
+            if (magic == 0x45535201)    // ESR_MAGIC
+            {
+                memcpy(&regs->ESR, reserved + offset + 8, sizeof(regs->ESR));
+                break;
+            }
+            offset += size;
+        }
+        stackPointer = (INTEGER_TYPE*)regs->SP;
+#else
+        // TODO: Store the registers for this architecture
+        (void)context;
+#endif
+    }
+
+    // A stack overflow faults on the guard page below the stack and the 
+    // faulting SP may point into the guard page. Read the stack starting at 
+    // the first page above the faulting address instead.
+    if (signalNumber == SIGSEGV && signalInfo != NULL && stackPointer != 0)
+    {
+        uintptr_t faultAddr = (uintptr_t)signalInfo->si_addr;
+        uintptr_t sp = (uintptr_t)stackPointer;
+        uintptr_t pageSize = _pageSize;
+        if (faultAddr + STACK_OVERFLOW_RANGE >= sp && faultAddr <= sp + STACK_OVERFLOW_RANGE)
+        {
+            uintptr_t validBegin = (faultAddr & ~(pageSize - 1)) + pageSize;
+            if (validBegin > sp)
+                stackPointer = (INTEGER_TYPE*)validBegin;
+        }
+    }
+
+    // Store the remaining core dump data. A stack pointer indicates a fault exception.
+    StoreCoreDump(stackPointer, fileName, lineNumber, (uint32_t)signalNumber, ASSERT_SITE_NONE);
+}
+#endif
+
+void CoreDumpClockCalibrate()
+{
+    CoreDumpClockCalibration calibration;
+    memset(&calibration, 0, sizeof(calibration));
+
+    // Sample the counter and monotonic clock together; the wall clock read 
+    // between them is assigned to their midpoint
+    uint64_t cycleCount = ReadCycleCounter();
+    uint64_t monotonicNs = ReadMonotonicNs();
+#ifdef __linux__
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    calibration.RealtimeNs = (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+#else
+    // TODO: Read the real time clock
+#endif
+    calibration.CycleCount = cycleCount + (ReadCycleCounter() - cycleCount) / 2;
+    calibration.MonotonicNs = monotonicNs + (ReadMonotonicNs() - monotonicNs) / 2;
+
+#if defined(__aarch64__)
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(calibration.CycleHz));
+#else
+    // Measure the counter frequency since the first calibration
+    if (_clockBase.MonotonicNs == 0)
+        _clockBase = calibration;
+    uint64_t elapsedNs = calibration.MonotonicNs - _clockBase.MonotonicNs;
+    if (elapsedNs >= 10000000)
+        calibration.CycleHz = (uint64_t)((double)(calibration.CycleCount - _clockBase.CycleCount) * 1e9 / elapsedNs);
+#endif
+
+    // Publish into the inactive buffer
+    uint32_t idx = _clockCalibrationIdx.load(std::memory_order_relaxed) + 1;
+    _clockCalibration[idx & 1] = calibration;
+    _clockCalibrationIdx.store(idx, std::memory_order_release);
+}
+
+// Check the key first; the CRC is only computed if a core dump is stored
+static bool IsSlotSaved(const CoreDumpData* coreDumpData)
+{
+    if (coreDumpData->Key == KEY_CORE_DUMP_STORED &&
+        coreDumpData->NotKey == ~KEY_CORE_DUMP_STORED &&
+        coreDumpData->Crc == CoreDumpCrc(coreDumpData))
         return true;
     else
         return false;
 }
 
+static void ResetSlot(CoreDumpData* coreDumpData, uint8_t* ecc)
+{
+    coreDumpData->Key = 0;
+    coreDumpData->NotKey = 0;
+    coreDumpData->Crc = 0;
+
+#ifdef USE_ECC_STORAGE
+    EccUpdate(coreDumpData, sizeof(*coreDumpData), ecc,
+        0, offsetof(CoreDumpData, Crc) + sizeof(coreDumpData->Crc));
+#else
+    (void)ecc;
+#endif
+}
+
+#ifdef USE_ECC_STORAGE
+static EccResult RepairSlot(CoreDumpData* coreDumpData, uint8_t* ecc)
+{
+    EccResult result = { 0, 0 };
+
+    // Check the key word first. Without a stored core dump the RAM contents
+    // are random and not worth scanning.
+    uint64_t keyWord;
+    uint8_t keyCheck = ecc[0];
+    memcpy(&keyWord, coreDumpData, sizeof(keyWord));
+    if (EccRepairWord(&keyWord, &keyCheck) < 0)
+        return result;
+
+    uint32_t keys[2];
+    memcpy(keys, &keyWord, sizeof(keys));
+    if (keys[0] != KEY_CORE_DUMP_STORED || keys[1] != ~KEY_CORE_DUMP_STORED)
+        return result;
+
+    // An intact core dump needs no repair
+    if (IsSlotSaved(coreDumpData))
+        return result;
+
+    return EccRepair(coreDumpData, sizeof(*coreDumpData), ecc);
+}
+#endif
+
+bool IsCoreDumpSaved()
+{
+    return IsSlotSaved(&_writeSlotData);
+}
+
 CoreDumpData* CoreDumpGet()
 {
-    return &_coreDumpData;
+    return &_writeSlotData;
 }
 
 void CoreDumpReset()
 {
-    _coreDumpData.Key = 0;
-    _coreDumpData.NotKey = 0;
+#ifdef USE_ECC_STORAGE
+    ResetSlot(&_writeSlotData, _writeSlotEcc);
+#else
+    ResetSlot(&_writeSlotData, NULL);
+#endif
+    _coreDumpStoring = false;
+
+#ifdef USE_FAST_BOOT
+    _bootHeader.PendingMask.fetch_and(~(1u << WRITE_SLOT));
+#endif
+}
+
+#ifdef USE_ECC_STORAGE
+EccResult CoreDumpEccRepair()
+{
+    return RepairSlot(&_writeSlotData, _writeSlotEcc);
+}
+#endif
+
+#ifdef USE_FAST_BOOT
+uint32_t CoreDumpBootDetect()
+{
+    uint64_t start = ReadMonotonicNs();
+    uint32_t pending = 0;
+    _coreDumpStoring = false;
+
+    if (_bootHeader.Key != KEY_CORE_DUMP_STORED || _bootHeader.NotKey != ~KEY_CORE_DUMP_STORED)
+    {
+        // Cold boot; the RAM contents are random
+        _bootHeader.WriteSlot = 0;
+        _bootHeader.PendingMask = 0;
+        _bootHeader.Key = KEY_CORE_DUMP_STORED;
+        _bootHeader.NotKey = ~KEY_CORE_DUMP_STORED;
+    }
+    else
+    {
+        pending = _bootHeader.PendingMask & ((1u << CORE_DUMP_SLOT_CNT) - 1);
+
+        // Move the write slot to a free slot. If none is free, faults are not
+        // stored until a slot is released.
+        for (uint32_t slot = 0; slot < CORE_DUMP_SLOT_CNT; slot++)
+        {
+            if (!(pending & (1u << slot)))
+            {
+                _bootHeader.WriteSlot = slot;
+                break;
+            }
+        }
+    }
+
+    _bootDetectTime = ReadMonotonicNs();
+    _bootStats.PendingMask = pending;
+    _bootStats.DetectNs = _bootDetectTime - start;
+    _bootStats.PersistNs = 0;
+    return pending;
+}
+
+CoreDumpData* CoreDumpSlotGet(uint32_t slot)
+{
+    if (slot >= CORE_DUMP_SLOT_CNT)
+        return NULL;
+    return &_coreDumpSlots[slot];
+}
+
+bool CoreDumpSlotValid(uint32_t slot)
+{
+    if (slot >= CORE_DUMP_SLOT_CNT)
+        return false;
+#ifdef USE_ECC_STORAGE
+    RepairSlot(&_coreDumpSlots[slot], _coreDumpEccSlots[slot]);
+#endif
+    return IsSlotSaved(&_coreDumpSlots[slot]);
 }
+
+void CoreDumpSlotRelease(uint32_t slot)
+{
+    if (slot >= CORE_DUMP_SLOT_CNT)
+        return;
+
+#ifdef USE_ECC_STORAGE
+    ResetSlot(&_coreDumpSlots[slot], _coreDumpEccSlots[slot]);
+#else
+    ResetSlot(&_coreDumpSlots[slot], NULL);
+#endif
+    _bootHeader.PendingMask.fetch_and(~(1u << slot));
+
+    // Every slot was full at boot; store the next fault in the released slot
+    if (_bootHeader.PendingMask & (1u << WRITE_SLOT))
+        _bootHeader.WriteSlot = slot;
+
+    _bootStats.PersistNs = ReadMonotonicNs() - _bootDetectTime;
+}
+
+CoreDumpBootStats CoreDumpBootGetStats()
+{
+    return _bootStats;
+}
+#endif
@@ -4,6 +4,23 @@
 #include "Options.h"
 #include <stdint.h>
 
+#ifdef USE_ECC_STORAGE
+#include "Ecc.h"
+#endif
+
+#ifdef USE_ASSERT_SITES
+#include "AssertSite.h"
+#endif
+
+#ifdef USE_LINUX_SIGNALS
+#include <signal.h>
+
+// Fault signal registers are stored for these architectures
+#if defined(__x86_64__) || defined(__aarch64__)
+#define USE_SIGNAL_REGISTERS
+#endif
+#endif
+
 // A marker used to indicate the top of the stack
 #define STACK_MARKER  0xEFEFEFEF
 
@@ -36,6 +53,79 @@
 // TODO: How many operating system tasks to store within the core dump.
 #define OS_TASKCNT  5
 
+// Maximum number of memory regions registered using CoreDumpRegisterRegion()
+#define MAX_MEMORY_REGIONS      16
+
+// Maximum memory region name length stored in core dump
+#define REGION_NAME_LEN         16
+
+// Number of bytes stored from the top of each stack (starting at the stack pointer)
+#define STACK_REGION_SIZE       256
+
+// Number of bytes stored around each faulting address held in R0-R3/LR
+#define FAULT_ADDRESS_REGION_SIZE   64
+
+// Total memory region storage within the core dump. Regions that do not fit
+// are truncated. Keep within the core dump RAM budget (e.g. 64k).
+#define MEMORY_REGION_BLOB_SIZE (48 * 1024)
+
+// Maximum number of memory regions stored in core dump. Registered regions,
+// a stack region per task, plus a region for each R0-R3/LR faulting address.
+#define MAX_STORED_REGIONS      (MAX_MEMORY_REGIONS + OS_TASKCNT + 1 + 5)
+
+// Number of raw stack bytes stored starting at the faulting stack pointer
+#define STACK_SLICE_SIZE        1024
+
+// Maximum number of stacks registered using StackPaintRegister()
+#define MAX_PAINTED_STACKS      16
+
+// Maximum number of thread stacks registered using StackBoundsRegister()
+#define MAX_THREAD_STACKS       64
+
+// Function entries held by each thread function history ring. Must be a 
+// power of 2.
+#define FUNCTION_HISTORY_SIZE   32
+
+// Number of double-buffered core dump slots used by USE_FAST_BOOT
+#define CORE_DUMP_SLOT_CNT      2
+
+// Maximum number of loaded modules (executable and shared libraries) known
+// to the module relative call stack encoding
+#define MAX_LOADED_MODULES      64
+
+// Maximum number of modules stored within each core dump
+#define MAX_STACK_MODULES       8
+
+#define MODULE_NAME_LEN         32
+#define BUILD_ID_LEN            20
+
+// Module index of a call stack address outside any known module. The offset
+// holds the low 32 bits of the absolute address.
+#define STACK_MODULE_NONE       0xFF
+
+// Registers stored for offline unwinding use DWARF register numbering
+#if defined(__x86_64__) || defined(_M_X64)
+#define UNWIND_REGISTER_CNT     17      // RAX..R15, RIP
+#define UNWIND_REGISTER_FP      6       // RBP
+#define UNWIND_REGISTER_SP      7       // RSP
+#define UNWIND_REGISTER_PC      16      // RIP (return address column)
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define UNWIND_REGISTER_CNT     33      // X0..X30, SP, PC
+#define UNWIND_REGISTER_FP      29      // X29
+#define UNWIND_REGISTER_SP      31      // SP
+#define UNWIND_REGISTER_PC      32      // PC
+#elif defined(__i386__) || defined(_M_IX86)
+#define UNWIND_REGISTER_CNT     9       // EAX..EDI, EIP
+#define UNWIND_REGISTER_FP      5       // EBP
+#define UNWIND_REGISTER_SP      4       // ESP
+#define UNWIND_REGISTER_PC      8       // EIP
+#else
+#define UNWIND_REGISTER_CNT     16      // R0..R15
+#define UNWIND_REGISTER_FP      7       // R7 (Thumb frame pointer)
+#define UNWIND_REGISTER_SP      13      // SP
+#define UNWIND_REGISTER_PC      15      // PC
+#endif
+
 #if (SIZE_MAX == UINT32_MAX)
 #define INTEGER_TYPE int32_t
 #elif (SIZE_MAX == UINT64_MAX)
@@ -50,18 +140,93 @@ enum FaultType
     SOFTWARE_ASSERTION      // Software assertion 
 };
 
+#ifdef USE_LINUX_SIGNALS
+/// x86-64 registers at the time of a fault signal
+struct CoreDumpX86_64Registers
+{
+    uint64_t RAX, RBX, RCX, RDX, RSI, RDI, RBP, RSP;
+    uint64_t R8, R9, R10, R11, R12, R13, R14, R15;
+    uint64_t RIP;
+    uint64_t EFLAGS;
+    uint64_t ERR;           // Page fault error code
+    uint64_t TRAPNO;        // Exception vector number
+    uint64_t CR2;           // Page fault linear address
+};
+
+/// AArch64 registers at the time of a fault signal
+struct CoreDumpAArch64Registers
+{
+    uint64_t X[31];         // X0-X30 (X29 is FP, X30 is LR)
+    uint64_t SP;
+    uint64_t PC;
+    uint64_t PSTATE;
+    uint64_t FAR;           // Fault address register
+    uint64_t ESR;           // Exception syndrome register
+};
+#endif
+
+/// Describes one memory region snapshot stored within CoreDumpData::RegionBlob
+struct CoreDumpRegion
+{
+    char Name[REGION_NAME_LEN];
+    INTEGER_TYPE Address;   // Original address of the captured memory
+    uint32_t Offset;        // Byte offset of the captured memory within RegionBlob
+    uint32_t Length;        // Number of bytes captured
+};
+
+/// Peak usage of a painted stack (see StackPaint.h)
+struct CoreDumpStackUsage
+{
+    char Name[REGION_NAME_LEN];
+    uint64_t Base;          // Lowest stack address
+    uint32_t Size;          // Stack size in bytes
+    uint32_t Peak;          // Deepest stack usage in bytes
+};
+
+#ifdef USE_MODULE_RELATIVE_STACK
+/// Describes one module referenced by the module relative call stack
+struct CoreDumpModule
+{
+    char Name[MODULE_NAME_LEN];     // File name without the directory
+    uint8_t BuildId[BUILD_ID_LEN];  // GNU build-id, if any
+    uint32_t BuildIdLength;
+    uint64_t LoadBase;              // Runtime address minus link-time address
+};
+#endif
+
+/// Cycle counter and monotonic clock to wall-clock calibration
+struct CoreDumpClockCalibration
+{
+    uint64_t CycleCount;    // Cycle counter at calibration
+    uint64_t MonotonicNs;   // CLOCK_MONOTONIC at calibration
+    uint64_t RealtimeNs;    // Wall-clock time since the Unix epoch at calibration
+    uint64_t CycleHz;       // Cycle counter frequency, or 0 if unknown
+};
+
 /// Core dump data structure
 class CoreDumpData
 {
 public:
     uint32_t Key;
     uint32_t NotKey;
+    uint32_t Crc;           // CRC32C of the whole structure computed with Crc = 0
     uint32_t SoftwareVersion;
     uint32_t AuxCode;
     FaultType Type;
 
     uint32_t LineNumber;
+#ifdef USE_ASSERT_SITES
+    uint16_t AssertSiteId;      // Failed assertion site id, or ASSERT_SITE_NONE
+#else
     char FileName[FILE_NAME_LEN];
+#endif
+
+    // Fault time. CycleCount is the x86 TSC or AArch64 CNTVCT_EL0 value and 
+    // orders faults across threads and cores. Clock is the latest calibration
+    // from CoreDumpClockCalibrate(); the decoder rebuilds the wall-clock time.
+    uint64_t CycleCount;
+    uint64_t MonotonicNs;
+    CoreDumpClockCalibration Clock;
 
 #ifdef USE_HARDWARE
     uint32_t R0_register;
@@ -74,11 +239,62 @@ public:
     uint32_t XPSR_register;
 #endif
 
+#ifdef USE_LINUX_SIGNALS
+    int32_t SignalNumber;       // Fatal signal number, or 0
+    int32_t SignalCode;         // siginfo_t si_code, e.g. SEGV_MAPERR
+    uint64_t SignalAddress;     // siginfo_t si_addr faulting address
+#if defined(USE_SIGNAL_REGISTERS) && defined(__x86_64__)
+    CoreDumpX86_64Registers Registers;
+#elif defined(USE_SIGNAL_REGISTERS)
+    CoreDumpAArch64Registers Registers;
+#endif
+#endif
+
+#ifdef USE_MODULE_RELATIVE_STACK
+    // Active call stack link-time offsets within Modules[ActiveCallStackModule]
+    uint32_t ActiveCallStackOffset[CALL_STACK_SIZE];
+    uint8_t ActiveCallStackModule[CALL_STACK_SIZE];
+    uint32_t ModuleCount;
+    CoreDumpModule Modules[MAX_STACK_MODULES];
+#else
     INTEGER_TYPE ActiveCallStack[CALL_STACK_SIZE];
+#endif
+
+#ifdef USE_FUNCTION_HISTORY
+    // Last functions entered by the faulting thread, most recent first, as
+    // offsets from FunctionHistoryBase (the executable load address)
+    uint64_t FunctionHistoryBase;
+    uint32_t FunctionHistoryCount;
+    uint32_t FunctionHistory[FUNCTION_HISTORY_SIZE];
+#endif
+
+#ifdef USE_STACK_SLICE
+    // Registers at the point the stack slice was captured. Bit N of 
+    // StackSliceRegisterMask is set if register N is valid.
+    uint64_t StackSliceRegisterMask;
+    INTEGER_TYPE StackSliceRegisters[UNWIND_REGISTER_CNT];
+
+    // Raw stack memory starting at StackSliceAddress
+    INTEGER_TYPE StackSliceAddress;
+    uint32_t StackSliceLength;
+    uint8_t StackSlice[STACK_SLICE_SIZE];
+#endif
 
 #ifdef USE_OPERATING_SYSTEM
     INTEGER_TYPE ThreadCallStacks[OS_TASKCNT][CALL_STACK_SIZE];
 #endif
+
+#ifdef USE_STACK_PAINT
+    uint32_t StackUsageCount;
+    CoreDumpStackUsage StackUsage[MAX_PAINTED_STACKS];
+#endif
+
+#ifdef USE_MEMORY_REGIONS
+    uint32_t RegionCount;
+    uint32_t RegionBlobUsed;
+    CoreDumpRegion Regions[MAX_STORED_REGIONS];
+    uint8_t RegionBlob[MEMORY_REGION_BLOB_SIZE];
+#endif
 };
 
 /// Store core dump data.
@@ -89,10 +305,47 @@ public:
 void CoreDumpStore(INTEGER_TYPE* stackPointer, const char* fileName,
     uint32_t lineNumber, uint32_t auxCode);
 
-/// Get the core dump saved state
+#ifdef USE_ASSERT_SITES
+/// Store core dump data for a failed assertion site.
+/// @param[in] site - the assertion site
+/// @param[in] auxCode - any additional number, or 0
+void CoreDumpStoreAssert(const AssertSite* site, uint32_t auxCode);
+#endif
+
+#ifdef USE_LINUX_SIGNALS
+/// Prepare CoreDumpStoreSignal() for use within a signal handler. Caches 
+/// the page size and loads the backtrace() unwinder, neither of which is 
+/// async-signal-safe. Called by SignalFaultInstall().
+void CoreDumpSignalInit();
+
+/// Store core dump data for a fatal signal. Called from a SA_SIGINFO signal 
+/// handler. Stores the faulting registers, signal code and faulting address.
+/// @param[in] signalNumber - the signal number, e.g. SIGSEGV
+/// @param[in] signalInfo - the siginfo_t signal handler argument
+/// @param[in] userContext - the ucontext_t signal handler argument
+/// @param[in] fileName - file name handling the signal
+/// @param[in] lineNumber - line number handling the signal
+void CoreDumpStoreSignal(int signalNumber, const siginfo_t* signalInfo, const void* userContext,
+    const char* fileName, uint32_t lineNumber);
+#endif
+
+/// Refresh the clock calibration copied into each core dump. Call at startup
+/// and then periodically (e.g. once a minute) from a single task so the 
+/// decoder can convert the fault time into wall-clock time. 
+/// ClockCalibratorStart() runs such a task.
+void CoreDumpClockCalibrate();
+
+/// Get the core dump saved state. The key and CRC32C of the whole core dump 
+/// structure are validated; a partially written or corrupted core dump is 
+/// not reported as saved.
 /// @return Returns true if core dump data is saved.
 bool IsCoreDumpSaved();
 
+/// Compute the CRC32C of a core dump data structure, excluding the Crc field.
+/// @param[in] coreDumpData - the core dump data structure
+/// @return The CRC32C value.
+uint32_t CoreDumpCrc(const CoreDumpData* coreDumpData);
+
 /// Get core dump data structure
 /// @return A pointer to the core dump data structure.
 CoreDumpData* CoreDumpGet();
@@ -100,4 +353,70 @@ CoreDumpData* CoreDumpGet();
 /// Reset core dump data structure.
 void CoreDumpReset();
 
+#ifdef USE_MODULE_RELATIVE_STACK
+/// Build the loaded module table used to encode call stack addresses. Call 
+/// at startup, and again after loading a shared library. Not async-signal-safe.
+/// @return The number of modules found.
+int CoreDumpModulesInit();
+#endif
+
+#ifdef USE_FAST_BOOT
+/// Boot time core dump statistics
+struct CoreDumpBootStats
+{
+    uint32_t PendingMask;   // Slots holding a core dump at boot
+    uint64_t DetectNs;      // Boot path time spent within CoreDumpBootDetect()
+    uint64_t PersistNs;     // Time from detection to the last CoreDumpSlotRelease()
+};
+
+/// Detect stored core dumps at boot. Reads the one cache line boot header;
+/// the core dump CRC is not computed. Call once at startup before any fault 
+/// can occur. A new fault is stored into a free slot.
+/// @return A bit mask of the slots holding a core dump to persist.
+uint32_t CoreDumpBootDetect();
+
+/// Get a core dump slot.
+/// @param[in] slot - the slot index
+/// @return A pointer to the slot core dump data structure.
+CoreDumpData* CoreDumpSlotGet(uint32_t slot);
+
+/// Validate a core dump slot key and CRC, repairing bit errors first if 
+/// USE_ECC_STORAGE is defined. Call from the deferred persistence task.
+/// @param[in] slot - the slot index
+/// @return True if the slot holds a valid core dump.
+bool CoreDumpSlotValid(uint32_t slot);
+
+/// Release a slot once its core dump is persisted. The slot becomes free
+/// for a future fault.
+/// @param[in] slot - the slot index
+void CoreDumpSlotRelease(uint32_t slot);
+
+/// Get the boot time core dump statistics
+CoreDumpBootStats CoreDumpBootGetStats();
+#endif
+
+#ifdef USE_ECC_STORAGE
+/// Repair bit errors within a core dump stored in unreliable RAM. Call once 
+/// at boot before IsCoreDumpSaved(). Returns immediately if no core dump is 
+/// stored or the stored core dump CRC is valid.
+/// @return The number of corrected and uncorrectable words.
+EccResult CoreDumpEccRepair();
+#endif
+
+#ifdef USE_MEMORY_REGIONS
+/// Register a memory region to store within the core dump. Register all 
+/// regions at startup; CoreDumpStore() copies each region into the core dump.
+/// @param[in] name - a short region name (truncated to REGION_NAME_LEN - 1)
+/// @param[in] address - the region start address
+/// @param[in] length - the region size in bytes
+/// @return Returns true if registered, false if MAX_MEMORY_REGIONS exceeded.
+bool CoreDumpRegisterRegion(const char* name, const void* address, uint32_t length);
+
+/// Get a memory region stored within the core dump.
+/// @param[in] coreDumpData - the core dump data structure
+/// @param[in] name - the region name
+/// @return A pointer to the region descriptor or NULL if not found.
+const CoreDumpRegion* CoreDumpFindRegion(const CoreDumpData* coreDumpData, const char* name);
+#endif
+
 #endif 
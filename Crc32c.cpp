@@ -0,0 +1,229 @@
+#include "Crc32c.h"
+#include "CoreDump.h"
+#include <cstddef>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <nmmintrin.h>
+#define USE_CRC32C_SSE42
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <nmmintrin.h>
+#include <intrin.h>
+#define USE_CRC32C_SSE42
+#define CRC32C_TARGET
+#elif defined(__GNUC__) && defined(__aarch64__)
+#include <arm_acle.h>
+#define USE_CRC32C_ARMV8
+#define CRC32C_TARGET __attribute__((target("+crc")))
+#ifdef __linux__
+#include <sys/auxv.h>
+#endif
+#endif
+
+// CRC32C polynomial, bit reflected
+#define CRC32C_POLY     0x82F63B78
+
+// Bytes per lane of the 3-way interleaved hardware CRC. Three independent
+// CRC streams hide the CRC32 instruction latency; the lanes are combined by
+// shifting a lane CRC over the following lanes using precomputed tables.
+#define CRC32C_LANE     256
+
+// Multiply two polynomials modulo the CRC32C polynomial (bit reflected)
+static constexpr uint32_t MultModP(uint32_t a, uint32_t b)
+{
+    uint32_t product = 0;
+    for (uint32_t m = 1u << 31; m != 0; m >>= 1)
+    {
+        if (a & m)
+            product ^= b;
+        b = (b & 1) ? (b >> 1) ^ CRC32C_POLY : b >> 1;
+    }
+    return product;
+}
+
+// x^(8 * bytes) modulo the CRC32C polynomial (bit reflected)
+static constexpr uint32_t ShiftConstant(uint32_t bytes)
+{
+    uint32_t p = 1u << 31;
+    for (uint32_t bit = 0; bit < bytes * 8; bit++)
+        p = (p & 1) ? (p >> 1) ^ CRC32C_POLY : p >> 1;
+    return p;
+}
+
+// Lookup tables generated at compile time
+struct Crc32cTables
+{
+    // Slicing-by-8 software tables
+    uint32_t Slice[8][256];
+
+    // Multiplies a CRC by x^(8 * CRC32C_LANE), one table per CRC byte
+    uint32_t Shift[4][256];
+
+    constexpr Crc32cTables() : Slice(), Shift()
+    {
+        for (uint32_t v = 0; v < 256; v++)
+        {
+            uint32_t crc = v;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+            Slice[0][v] = crc;
+        }
+        for (uint32_t v = 0; v < 256; v++)
+        {
+            for (int k = 1; k < 8; k++)
+                Slice[k][v] = (Slice[k - 1][v] >> 8) ^ Slice[0][Slice[k - 1][v] & 0xFF];
+        }
+
+        const uint32_t shift = ShiftConstant(CRC32C_LANE);
+        for (uint32_t v = 0; v < 256; v++)
+        {
+            for (int k = 0; k < 4; k++)
+                Shift[k][v] = MultModP(v << (8 * k), shift);
+        }
+    }
+};
+
+static constexpr Crc32cTables _tables;
+
+// Read a little-endian 64-bit word from an unaligned address
+static inline uint64_t Load64(const uint8_t* data)
+{
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Software slicing-by-8 CRC. crc is the raw (non-inverted) CRC register.
+static uint32_t Crc32cSoftware(uint32_t crc, const uint8_t* data, size_t length)
+{
+    while (length > 0 && ((uintptr_t)data & 7) != 0)
+    {
+        crc = (crc >> 8) ^ _tables.Slice[0][(crc ^ *data++) & 0xFF];
+        length--;
+    }
+
+    while (length >= 8)
+    {
+        uint64_t word = Load64(data) ^ crc;
+        crc = _tables.Slice[7][word & 0xFF] ^
+            _tables.Slice[6][(word >> 8) & 0xFF] ^
+            _tables.Slice[5][(word >> 16) & 0xFF] ^
+            _tables.Slice[4][(word >> 24) & 0xFF] ^
+            _tables.Slice[3][(word >> 32) & 0xFF] ^
+            _tables.Slice[2][(word >> 40) & 0xFF] ^
+            _tables.Slice[1][(word >> 48) & 0xFF] ^
+            _tables.Slice[0][word >> 56];
+        data += 8;
+        length -= 8;
+    }
+
+    while (length > 0)
+    {
+        crc = (crc >> 8) ^ _tables.Slice[0][(crc ^ *data++) & 0xFF];
+        length--;
+    }
+    return crc;
+}
+
+#if defined(USE_CRC32C_SSE42) || defined(USE_CRC32C_ARMV8)
+
+#ifdef USE_CRC32C_SSE42
+#define CRC32C_U8(crc, value)   _mm_crc32_u8(crc, value)
+#define CRC32C_U64(crc, value)  (uint32_t)_mm_crc32_u64(crc, value)
+#else
+#define CRC32C_U8(crc, value)   __crc32cb(crc, value)
+#define CRC32C_U64(crc, value)  __crc32cd(crc, value)
+#endif
+
+// Shift a CRC over CRC32C_LANE zero bytes
+static inline uint32_t ShiftLane(uint32_t crc)
+{
+    return _tables.Shift[0][crc & 0xFF] ^
+        _tables.Shift[1][(crc >> 8) & 0xFF] ^
+        _tables.Shift[2][(crc >> 16) & 0xFF] ^
+        _tables.Shift[3][crc >> 24];
+}
+
+// Hardware CRC. crc is the raw (non-inverted) CRC register.
+CRC32C_TARGET static uint32_t Crc32cHardware(uint32_t crc, const uint8_t* data, size_t length)
+{
+    while (length > 0 && ((uintptr_t)data & 7) != 0)
+    {
+        crc = CRC32C_U8(crc, *data++);
+        length--;
+    }
+
+    // Three independent streams per iteration
+    while (length >= 3 * CRC32C_LANE)
+    {
+        uint32_t crc1 = 0, crc2 = 0;
+        for (size_t offset = 0; offset < CRC32C_LANE; offset += 8)
+        {
+            crc = CRC32C_U64(crc, Load64(data + offset));
+            crc1 = CRC32C_U64(crc1, Load64(data + CRC32C_LANE + offset));
+            crc2 = CRC32C_U64(crc2, Load64(data + 2 * CRC32C_LANE + offset));
+        }
+        crc = ShiftLane(ShiftLane(crc) ^ crc1) ^ crc2;
+        data += 3 * CRC32C_LANE;
+        length -= 3 * CRC32C_LANE;
+    }
+
+    while (length >= 8)
+    {
+        crc = CRC32C_U64(crc, Load64(data));
+        data += 8;
+        length -= 8;
+    }
+
+    while (length > 0)
+    {
+        crc = CRC32C_U8(crc, *data++);
+        length--;
+    }
+    return crc;
+}
+
+// Returns true if the CPU supports the CRC32C instructions
+static bool IsHardwareSupported()
+{
+#if defined(USE_CRC32C_SSE42) && defined(__GNUC__)
+    return __builtin_cpu_supports("sse4.2");
+#elif defined(USE_CRC32C_SSE42)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#elif defined(__ARM_FEATURE_CRC32)
+    return true;
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    return false;
+#endif
+}
+#endif
+
+uint32_t Crc32c(uint32_t crc, const void* data, size_t length)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+
+#if defined(USE_CRC32C_SSE42) || defined(USE_CRC32C_ARMV8)
+    // Detected once; static init is safe in a fault handler after the first call
+    static const bool hardware = IsHardwareSupported();
+    if (hardware)
+        return ~Crc32cHardware(~crc, bytes, length);
+#endif
+    return ~Crc32cSoftware(~crc, bytes, length);
+}
+
+// Defined here rather than in CoreDump.cpp so the decoder and collector, 
+// which link Crc32c.cpp only, validate core dumps with the same function
+uint32_t CoreDumpCrc(const CoreDumpData* coreDumpData)
+{
+    const uint8_t* data = (const uint8_t*)coreDumpData;
+    const size_t crcOffset = offsetof(CoreDumpData, Crc);
+    const size_t crcEnd = crcOffset + sizeof(coreDumpData->Crc);
+
+    uint32_t crc = Crc32c(0, data, crcOffset);
+    return Crc32c(crc, data + crcEnd, sizeof(CoreDumpData) - crcEnd);
+}
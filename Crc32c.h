@@ -0,0 +1,16 @@
+#ifndef _CRC32C_H
+#define _CRC32C_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/// Compute a CRC32C (Castagnoli) checksum. Uses the SSE4.2 or ARMv8 CRC32 
+/// instructions when the CPU supports them, otherwise a slicing-by-8 table.
+/// Safe to call from a fault handler; no initialization or allocation required.
+/// @param[in] crc - the CRC of the preceding data, or 0 to start
+/// @param[in] data - the data to checksum
+/// @param[in] length - the data length in bytes
+/// @return The CRC32C of all data up to and including this block.
+uint32_t Crc32c(uint32_t crc, const void* data, size_t length);
+
+#endif 
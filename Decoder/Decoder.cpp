@@ -0,0 +1,724 @@
+// Host-side core dump decoder. Translates a binary CoreDumpData image saved
+// by the target into dump.txt text format. Build the decoder using the same
+// Options.h settings and pointer size as the target application so the 
+// CoreDumpData layout matches.
+//
+// Usage: CoreDumpDecoder <dump.bin> [--elf <executable> [--bias <load bias>]]
+//                        [--code <begin> <end>] [--minidump <file>]
+//                        [--core <file>]
+//        CoreDumpDecoder <snapshot.store> --snapshots
+//        CoreDumpDecoder <coredump.store> --record <sequence> [--elf ...]
+//
+// The dump file is either the raw CoreDumpData image or a compressed stream
+// written by CompressStream().
+//
+// With --record, the core dump is read from a store written by the uploader 
+// or the collector. A record flagged DUMP_RECORD_COMPRESSED is decompressed 
+// (Linux only).
+//
+// With --elf, the stack slice is unwound using the executable's .eh_frame or 
+// .debug_frame call frame information. --bias is the runtime load address 
+// minus the link-time address of a position independent executable.
+//
+// With --minidump, the core dump is also converted into a minidump file 
+// readable by Breakpad and Crashpad based tools (Linux only). With --core, it 
+// is converted into an ELF core file holding only the captured memory that
+// gdb can load together with the executable (Linux only).
+//
+// With --snapshots, the file is a live snapshot store written by
+// SnapshotTake() and the call stacks of every snapshot are printed (Linux
+// only).
+
+#include "CoreDump.h"
+#include "Crc32c.h"
+#include "Compress.h"
+#include "ElfFile.h"
+#include "DwarfCfi.h"
+#include "StackUnwind.h"
+#include "Minidump.h"
+#include "ElfCore.h"
+#ifdef __linux__
+#include "DumpStore.h"
+#include "Snapshot.h"
+#endif
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Print the raw stack words between two stack addresses (the frame locals)
+#ifdef USE_STACK_SLICE
+static void PrintFrameLocals(const CoreDumpData* coreDumpData, INTEGER_TYPE begin, INTEGER_TYPE end)
+{
+    INTEGER_TYPE value = 0;
+    for (INTEGER_TYPE addr = begin; addr < end; addr += sizeof(INTEGER_TYPE))
+    {
+        if (!StackSliceRead(coreDumpData, addr, &value))
+            break;
+        printf("    [0x%llx] 0x%llx\n", (unsigned long long)addr, (unsigned long long)value);
+    }
+}
+
+// Print the call stack frames rebuilt from the stack slice
+static void PrintStackSlice(const CoreDumpData* coreDumpData, CfiUnwinder* unwinder,
+    INTEGER_TYPE codeBegin, INTEGER_TYPE codeEnd)
+{
+    UnwindFrame frames[MAX_UNWIND_FRAMES];
+
+    printf("Stack Slice: 0x%llx (%u bytes)\n", 
+        (unsigned long long)coreDumpData->StackSliceAddress, coreDumpData->StackSliceLength);
+    for (int r = 0; r < UNWIND_REGISTER_CNT; r++)
+    {
+        if (coreDumpData->StackSliceRegisterMask & (1ull << r))
+            printf("Reg %d: 0x%llx\n", r, (unsigned long long)coreDumpData->StackSliceRegisters[r]);
+    }
+    printf("\n");
+
+    int frameCnt = StackUnwind(coreDumpData, unwinder, codeBegin, codeEnd, frames, MAX_UNWIND_FRAMES);
+    int f = 0;
+    for (; f < frameCnt && !frames[f].Scanned; f++)
+    {
+        printf("Frame %d: 0x%llx", f, (unsigned long long)frames[f].PC);
+        if (frames[f].CFA != 0)
+        {
+            printf(" (SP 0x%llx CFA 0x%llx%s)\n", (unsigned long long)frames[f].SP, 
+                (unsigned long long)frames[f].CFA, frames[f].Cfi ? " CFI" : "");
+            PrintFrameLocals(coreDumpData, frames[f].SP, frames[f].CFA);
+        }
+        else
+        {
+            printf(" (SP 0x%llx)\n", (unsigned long long)frames[f].SP);
+        }
+    }
+    printf("\n");
+
+    // Code addresses found on the stack after the unwind failed. These may be
+    // stale values from earlier calls rather than callers.
+    if (f < frameCnt)
+    {
+        printf("Scanned Return Addresses (heuristic):\n");
+        for (; f < frameCnt; f++)
+            printf("Scan %d: 0x%llx (found at 0x%llx)\n", f, (unsigned long long)frames[f].PC,
+                (unsigned long long)frames[f].SP);
+        printf("\n");
+    }
+}
+#endif
+
+#if defined(USE_SIGNAL_REGISTERS) && defined(__x86_64__)
+// Print the x86-64 registers stored by a fatal signal
+static void PrintSignalRegisters(const CoreDumpX86_64Registers* regs)
+{
+    printf("RAX: 0x%llx\n", (unsigned long long)regs->RAX);
+    printf("RBX: 0x%llx\n", (unsigned long long)regs->RBX);
+    printf("RCX: 0x%llx\n", (unsigned long long)regs->RCX);
+    printf("RDX: 0x%llx\n", (unsigned long long)regs->RDX);
+    printf("RSI: 0x%llx\n", (unsigned long long)regs->RSI);
+    printf("RDI: 0x%llx\n", (unsigned long long)regs->RDI);
+    printf("RBP: 0x%llx\n", (unsigned long long)regs->RBP);
+    printf("RSP: 0x%llx\n", (unsigned long long)regs->RSP);
+    printf("R8: 0x%llx\n", (unsigned long long)regs->R8);
+    printf("R9: 0x%llx\n", (unsigned long long)regs->R9);
+    printf("R10: 0x%llx\n", (unsigned long long)regs->R10);
+    printf("R11: 0x%llx\n", (unsigned long long)regs->R11);
+    printf("R12: 0x%llx\n", (unsigned long long)regs->R12);
+    printf("R13: 0x%llx\n", (unsigned long long)regs->R13);
+    printf("R14: 0x%llx\n", (unsigned long long)regs->R14);
+    printf("R15: 0x%llx\n", (unsigned long long)regs->R15);
+    printf("RIP: 0x%llx\n", (unsigned long long)regs->RIP);
+    printf("EFLAGS: 0x%llx\n", (unsigned long long)regs->EFLAGS);
+    printf("ERR: 0x%llx\n", (unsigned long long)regs->ERR);
+    printf("TRAPNO: %llu\n", (unsigned long long)regs->TRAPNO);
+    printf("CR2: 0x%llx\n\n", (unsigned long long)regs->CR2);
+}
+#elif defined(USE_SIGNAL_REGISTERS)
+// Print the AArch64 registers stored by a fatal signal
+static void PrintSignalRegisters(const CoreDumpAArch64Registers* regs)
+{
+    for (int r = 0; r < 31; r++)
+        printf("X%d: 0x%llx\n", r, (unsigned long long)regs->X[r]);
+    printf("SP: 0x%llx\n", (unsigned long long)regs->SP);
+    printf("PC: 0x%llx\n", (unsigned long long)regs->PC);
+    printf("PSTATE: 0x%llx\n", (unsigned long long)regs->PSTATE);
+    printf("FAR: 0x%llx\n", (unsigned long long)regs->FAR);
+    printf("ESR: 0x%llx\n\n", (unsigned long long)regs->ESR);
+}
+#endif
+
+#ifdef USE_MODULE_RELATIVE_STACK
+// Print the module table and the module relative active call stack. Offsets
+// are link-time addresses; pass each to addr2line with the named module.
+static void PrintModuleRelativeStack(const CoreDumpData* coreDumpData)
+{
+    uint32_t moduleCnt = coreDumpData->ModuleCount;
+    if (moduleCnt > MAX_STACK_MODULES)
+        moduleCnt = MAX_STACK_MODULES;
+
+    for (uint32_t m = 0; m < moduleCnt; m++)
+    {
+        const CoreDumpModule* module = &coreDumpData->Modules[m];
+        printf("Module %u: %.*s base 0x%llx build-id ", m, MODULE_NAME_LEN, module->Name,
+            (unsigned long long)module->LoadBase);
+        for (uint32_t b = 0; b < module->BuildIdLength && b < BUILD_ID_LEN; b++)
+            printf("%02x", module->BuildId[b]);
+        printf("\n");
+    }
+    printf("\n");
+
+    for (int s = 0; s < CALL_STACK_SIZE; s++)
+    {
+        uint8_t m = coreDumpData->ActiveCallStackModule[s];
+        if (m < moduleCnt)
+            printf("Stack %d: %.*s+0x%x\n", s, MODULE_NAME_LEN, coreDumpData->Modules[m].Name,
+                coreDumpData->ActiveCallStackOffset[s]);
+        else
+            printf("Stack %d: 0x%x\n", s, coreDumpData->ActiveCallStackOffset[s]);
+    }
+    printf("\n");
+}
+#endif
+
+#ifdef USE_ASSERT_SITES
+// Print the failed assertion site id, and the site file name read from the 
+// executable assert_sites section
+static void PrintAssertSite(const CoreDumpData* coreDumpData, const ElfFile* elf)
+{
+    if (coreDumpData->AssertSiteId == ASSERT_SITE_NONE)
+    {
+        printf("Assert Site: none\n");
+        return;
+    }
+    printf("Assert Site: %u\n", coreDumpData->AssertSiteId);
+    if (elf == NULL)
+        return;
+
+    // AssertSite layout: 64-bit failure counter, file name pointer, line
+    const ElfSection* sites = elf->FindSection(ASSERT_SITE_SECTION);
+    uint64_t offset = (uint64_t)coreDumpData->AssertSiteId * ASSERT_SITE_SIZE;
+    if (sites == NULL || sites->Data == NULL || offset + ASSERT_SITE_SIZE > sites->Size)
+    {
+        printf("File Name: unknown (site not in %s)\n", elf->Path().c_str());
+        return;
+    }
+
+    // The File pointer follows the 64-bit failure counter. In a position 
+    // independent executable it is a dynamic relocation.
+    uint64_t address = 0;
+    elf->ReadPointer(sites->Address + offset + 8, &address);
+    const ElfSection* strings = elf->FindSectionByAddress(address);
+    if (strings == NULL || strings->Data == NULL)
+    {
+        printf("File Name: unknown\n");
+        return;
+    }
+    const char* fileName = (const char*)strings->Data + (address - strings->Address);
+    size_t length = strnlen(fileName, (size_t)(strings->Size - (address - strings->Address)));
+    printf("File Name: %.*s\n", (int)length, fileName);
+}
+#endif
+
+// Print the fault timestamps and the wall-clock fault time rebuilt from the
+// clock calibration stored with the core dump
+static void PrintFaultTime(const CoreDumpData* coreDumpData)
+{
+    const CoreDumpClockCalibration* clock = &coreDumpData->Clock;
+    printf("Cycle Count: %llu\n", (unsigned long long)coreDumpData->CycleCount);
+    printf("Monotonic Time: %llu.%09llu s\n", (unsigned long long)(coreDumpData->MonotonicNs / 1000000000),
+        (unsigned long long)(coreDumpData->MonotonicNs % 1000000000));
+
+    // Prefer the monotonic clock offset; otherwise convert the cycle count
+    int64_t offsetNs;
+    if (coreDumpData->MonotonicNs != 0 && clock->MonotonicNs != 0)
+        offsetNs = (int64_t)(coreDumpData->MonotonicNs - clock->MonotonicNs);
+    else if (clock->CycleHz != 0)
+        offsetNs = (int64_t)((double)(int64_t)(coreDumpData->CycleCount - clock->CycleCount) * 1e9 / clock->CycleHz);
+    else
+        clock = NULL;
+
+    if (clock == NULL || clock->RealtimeNs == 0)
+    {
+        printf("Fault Time: unknown (no clock calibration)\n");
+        return;
+    }
+
+    uint64_t timeNs = clock->RealtimeNs + offsetNs;
+    time_t seconds = (time_t)(timeNs / 1000000000);
+    char text[32] = "?";
+    const struct tm* utc = gmtime(&seconds);
+    if (utc != NULL)
+        strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", utc);
+    printf("Fault Time: %s.%09llu UTC\n", text, (unsigned long long)(timeNs % 1000000000));
+    if (clock->CycleHz != 0)
+        printf("Cycle Counter: %llu Hz\n", (unsigned long long)clock->CycleHz);
+}
+
+// Print the core dump contents in dump.txt format
+static void PrintCoreDump(const CoreDumpData* coreDumpData, const ElfFile* elf, 
+    CfiUnwinder* unwinder, INTEGER_TYPE codeBegin, INTEGER_TYPE codeEnd)
+{
+    printf("Type: %s\n", coreDumpData->Type == FAULT_EXCEPTION ? "Fault Exception" : "Software Assertion");
+#ifdef USE_ASSERT_SITES
+    PrintAssertSite(coreDumpData, elf);
+#else
+    (void)elf;
+    char fileName[FILE_NAME_LEN];
+    memcpy(fileName, coreDumpData->FileName, FILE_NAME_LEN);
+    fileName[FILE_NAME_LEN - 1] = 0;
+    printf("File Name: %s\n", fileName);
+#endif
+    printf("Line Number: %u\n", coreDumpData->LineNumber);
+    printf("Aux Code: %u\n", coreDumpData->AuxCode);
+    printf("Software Version: %u\n", coreDumpData->SoftwareVersion);
+    PrintFaultTime(coreDumpData);
+    printf("\n");
+
+#ifdef USE_HARDWARE
+    printf("R0: 0x%x\n", coreDumpData->R0_register);
+    printf("R1: 0x%x\n", coreDumpData->R1_register);
+    printf("R2: 0x%x\n", coreDumpData->R2_register);
+    printf("R3: 0x%x\n", coreDumpData->R3_register);
+    printf("R12: 0x%x\n", coreDumpData->R12_register);
+    printf("LR: 0x%x\n", coreDumpData->LR_register);
+    printf("PC: 0x%x\n", coreDumpData->PC_register);
+    printf("xPSR: 0x%x\n\n", coreDumpData->XPSR_register);
+#endif
+
+#ifdef USE_LINUX_SIGNALS
+    if (coreDumpData->SignalNumber != 0)
+    {
+        printf("Signal: %d\n", coreDumpData->SignalNumber);
+        printf("Signal Code: %d\n", coreDumpData->SignalCode);
+        printf("Signal Address: 0x%llx\n\n", (unsigned long long)coreDumpData->SignalAddress);
+#ifdef USE_SIGNAL_REGISTERS
+        PrintSignalRegisters(&coreDumpData->Registers);
+#endif
+    }
+#endif
+
+#ifdef USE_MODULE_RELATIVE_STACK
+    PrintModuleRelativeStack(coreDumpData);
+#else
+    for (int s = 0; s < CALL_STACK_SIZE; s++)
+        printf("Stack %d: 0x%llx\n", s, (unsigned long long)coreDumpData->ActiveCallStack[s]);
+    printf("\n");
+#endif
+
+#ifdef USE_FUNCTION_HISTORY
+    // Offsets are link-time addresses for a position independent executable
+    uint32_t historyCnt = coreDumpData->FunctionHistoryCount;
+    if (historyCnt > FUNCTION_HISTORY_SIZE)
+        historyCnt = FUNCTION_HISTORY_SIZE;
+    printf("Function History Base: 0x%llx\n", (unsigned long long)coreDumpData->FunctionHistoryBase);
+    for (uint32_t h = 0; h < historyCnt; h++)
+        printf("History %u: +0x%x\n", h, coreDumpData->FunctionHistory[h]);
+    printf("\n");
+#endif
+
+#ifdef USE_OPERATING_SYSTEM
+    for (int t = 0; t < OS_TASKCNT; t++)
+    {
+        for (int s = 0; s < CALL_STACK_SIZE; s++)
+            printf("Task %d Stack %d: 0x%llx\n", t, s, (unsigned long long)coreDumpData->ThreadCallStacks[t][s]);
+    }
+    printf("\n");
+#endif
+
+#ifdef USE_STACK_PAINT
+    uint32_t stackCnt = coreDumpData->StackUsageCount;
+    if (stackCnt > MAX_PAINTED_STACKS)
+        stackCnt = MAX_PAINTED_STACKS;
+    for (uint32_t t = 0; t < stackCnt; t++)
+    {
+        const CoreDumpStackUsage* usage = &coreDumpData->StackUsage[t];
+        printf("Stack Usage %.*s: %u of %u bytes (%u%%) at 0x%llx\n", REGION_NAME_LEN, usage->Name,
+            usage->Peak, usage->Size, usage->Size != 0 ? (uint32_t)((uint64_t)usage->Peak * 100 / usage->Size) : 0,
+            (unsigned long long)usage->Base);
+    }
+    if (stackCnt != 0)
+        printf("\n");
+#endif
+
+#ifdef USE_MEMORY_REGIONS
+    uint32_t regionCnt = coreDumpData->RegionCount;
+    if (regionCnt > MAX_STORED_REGIONS)
+        regionCnt = MAX_STORED_REGIONS;
+    for (uint32_t r = 0; r < regionCnt; r++)
+    {
+        const CoreDumpRegion* region = &coreDumpData->Regions[r];
+        printf("Region %.*s: 0x%llx (%u bytes)\n", REGION_NAME_LEN, region->Name,
+            (unsigned long long)region->Address, region->Length);
+    }
+    printf("\n");
+#endif
+
+#ifdef USE_STACK_SLICE
+    PrintStackSlice(coreDumpData, unwinder, codeBegin, codeEnd);
+#else
+    (void)unwinder;
+    (void)codeBegin;
+    (void)codeEnd;
+#endif
+}
+
+#ifdef __linux__
+// Print every live snapshot within a snapshot store
+static int PrintSnapshots(const char* path)
+{
+    static DumpStore store;
+    if (!store.Open(path))
+    {
+        fprintf(stderr, "Cannot open snapshot store %s\n", path);
+        return 1;
+    }
+
+    // The snapshot is large; don't place on the stack
+    static SnapshotData snapshot;
+    DumpRecordHeader header;
+    uint64_t offset = 0;
+    uint64_t next = 0;
+    DumpReadResult result;
+    while ((result = store.Read(offset, &header, &snapshot, sizeof(snapshot), &next)) != DUMP_READ_END)
+    {
+        offset = next;
+        if (result == DUMP_READ_TOO_LARGE)
+        {
+            fprintf(stderr, "Record %llu is not a snapshot\n", (unsigned long long)header.Sequence);
+            continue;
+        }
+        if (header.Flags & DUMP_RECORD_DUPLICATE)
+        {
+            printf("Record %llu: same call stacks as an earlier snapshot\n\n", (unsigned long long)header.Sequence);
+            continue;
+        }
+        if (header.Length < offsetof(SnapshotData, Threads) || snapshot.Magic != SNAPSHOT_MAGIC)
+        {
+            fprintf(stderr, "Record %llu is not a snapshot\n", (unsigned long long)header.Sequence);
+            continue;
+        }
+
+        uint32_t threadCnt = (uint32_t)((header.Length - offsetof(SnapshotData, Threads)) / sizeof(SnapshotThread));
+        if (threadCnt > snapshot.ThreadCount)
+            threadCnt = snapshot.ThreadCount;
+
+        time_t seconds = (time_t)(snapshot.RealtimeNs / 1000000000);
+        char text[32] = "?";
+        const struct tm* utc = gmtime(&seconds);
+        if (utc != NULL)
+            strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", utc);
+        printf("Snapshot: %llu\n", (unsigned long long)snapshot.Sequence);
+        printf("Software Version: %u\n", snapshot.SoftwareVersion);
+        printf("Snapshot Time: %s.%09llu UTC\n", text, (unsigned long long)(snapshot.RealtimeNs % 1000000000));
+        printf("Pause: %llu us\n", (unsigned long long)(snapshot.PauseNs / 1000));
+        printf("Threads: %u (%u missed)\n\n", snapshot.ThreadCount, snapshot.Missed);
+
+        for (uint32_t t = 0; t < threadCnt; t++)
+        {
+            const SnapshotThread* thread = &snapshot.Threads[t];
+            if (thread->ThreadId == 0)
+                continue;
+            uint32_t depth = thread->Depth < SNAPSHOT_STACK_DEPTH ? thread->Depth : SNAPSHOT_STACK_DEPTH;
+            printf("Thread %u %.*s\n", thread->ThreadId, SNAPSHOT_THREAD_NAME_LEN, thread->Name);
+            for (uint32_t s = 0; s < depth; s++)
+                printf("Stack %u: 0x%llx\n", s, (unsigned long long)thread->CallStack[s]);
+#ifdef USE_FUNCTION_HISTORY
+            uint32_t historyCnt = thread->FunctionHistoryCount;
+            if (historyCnt > FUNCTION_HISTORY_SIZE)
+                historyCnt = FUNCTION_HISTORY_SIZE;
+            if (historyCnt != 0)
+                printf("Function History Base: 0x%llx\n", (unsigned long long)thread->FunctionHistoryBase);
+            for (uint32_t h = 0; h < historyCnt; h++)
+                printf("History %u: +0x%x\n", h, thread->FunctionHistory[h]);
+#endif
+            printf("\n");
+        }
+        memset(&snapshot, 0, sizeof(snapshot));
+    }
+    return 0;
+}
+
+// Read a core dump record from a core dump store
+// @return The core dump size in bytes, or -1 on failure.
+static long ReadStoreRecord(const char* path, uint64_t sequence, CoreDumpData* coreDumpData)
+{
+    static DumpStore store;
+    if (!store.Open(path))
+    {
+        fprintf(stderr, "Cannot open core dump store %s\n", path);
+        return -1;
+    }
+
+    // Large enough for a raw core dump or a compressed stream of one
+    static uint8_t record[COMPRESS_STREAM_BOUND(sizeof(CoreDumpData))];
+    DumpRecordHeader header;
+    uint64_t offset = 0;
+    uint64_t next = 0;
+    DumpReadResult result;
+    while ((result = store.Read(offset, &header, record, sizeof(record), &next)) != DUMP_READ_END)
+    {
+        offset = next;
+        if (header.Sequence != sequence)
+            continue;
+        if (result == DUMP_READ_TOO_LARGE)
+        {
+            fprintf(stderr, "Record %llu is not a core dump\n", (unsigned long long)sequence);
+            return -1;
+        }
+        if (header.Flags & DUMP_RECORD_DUPLICATE)
+        {
+            fprintf(stderr, "Record %llu has the same call stack as an earlier record; no data stored\n", 
+                (unsigned long long)sequence);
+            return -1;
+        }
+        if (header.Flags & DUMP_RECORD_COMPRESSED)
+        {
+            long size = DecompressStream(record, header.Length, coreDumpData, sizeof(*coreDumpData));
+            if (size < 0)
+                fprintf(stderr, "Corrupt compressed record %llu\n", (unsigned long long)sequence);
+            return size;
+        }
+        size_t size = header.Length < sizeof(*coreDumpData) ? header.Length : sizeof(*coreDumpData);
+        memcpy(coreDumpData, record, size);
+        return (long)size;
+    }
+    fprintf(stderr, "No record %llu within %s\n", (unsigned long long)sequence, path);
+    return -1;
+}
+#endif
+
+static uint32_t ReadLE32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Decompress a compressed stream one block at a time into dest. Returns the
+// decompressed size, or -1 if the stream is malformed or truncated.
+static long ReadCompressedStream(FILE* file, void* dest, size_t capacity)
+{
+    static uint8_t block[COMPRESS_BLOCK_BOUND(COMPRESS_BLOCK_SIZE)];
+    uint8_t header[COMPRESS_HEADER_SIZE];
+    uint8_t* op = (uint8_t*)dest;
+
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || 
+        ReadLE32(header) != COMPRESS_MAGIC)
+        return -1;
+
+    size_t length = ReadLE32(header + 4);
+    if (length > capacity)
+        return -1;
+
+    size_t size = 0;
+    while (size < length)
+    {
+        if (fread(header, 1, 4, file) != 4)
+            return -1;
+        uint32_t blockHeader = ReadLE32(header);
+        size_t payload = blockHeader & ~COMPRESS_BLOCK_STORED;
+        size_t expected = length - size < COMPRESS_BLOCK_SIZE ? length - size : COMPRESS_BLOCK_SIZE;
+
+        if (blockHeader & COMPRESS_BLOCK_STORED)
+        {
+            if (payload != expected || fread(op + size, 1, payload, file) != payload)
+                return -1;
+        }
+        else
+        {
+            if (payload > sizeof(block) || fread(block, 1, payload, file) != payload ||
+                DecompressBlock(block, payload, op + size, expected) != (int)expected)
+                return -1;
+        }
+        size += expected;
+    }
+    return (long)size;
+}
+
+int main(int argc, char* argv[])
+{
+    INTEGER_TYPE codeBegin = FLASH_BASE;
+    INTEGER_TYPE codeEnd = FLASH_END;
+    const char* elfPath = NULL;
+    const char* minidumpPath = NULL;
+    const char* corePath = NULL;
+    uint64_t loadBias = 0;
+    uint64_t recordSequence = 0;
+    bool codeRangeSet = false;
+    bool recordSet = false;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <dump.bin> [--elf <executable> [--bias <load bias>]] "
+            "[--code <begin> <end>] [--minidump <file>] [--core <file>]\n"
+            "       %s <snapshot.store> --snapshots\n"
+            "       %s <coredump.store> --record <sequence> [--elf ...]\n", argv[0], argv[0], argv[0]);
+        return 1;
+    }
+
+    for (int a = 2; a < argc; a++)
+    {
+        if (strcmp(argv[a], "--code") == 0 && a + 2 < argc)
+        {
+            codeBegin = (INTEGER_TYPE)strtoull(argv[++a], NULL, 0);
+            codeEnd = (INTEGER_TYPE)strtoull(argv[++a], NULL, 0);
+            codeRangeSet = true;
+        }
+        else if (strcmp(argv[a], "--elf") == 0 && a + 1 < argc)
+            elfPath = argv[++a];
+        else if (strcmp(argv[a], "--bias") == 0 && a + 1 < argc)
+            loadBias = strtoull(argv[++a], NULL, 0);
+        else if (strcmp(argv[a], "--minidump") == 0 && a + 1 < argc)
+            minidumpPath = argv[++a];
+        else if (strcmp(argv[a], "--core") == 0 && a + 1 < argc)
+            corePath = argv[++a];
+        else if (strcmp(argv[a], "--record") == 0 && a + 1 < argc)
+        {
+            recordSequence = strtoull(argv[++a], NULL, 0);
+            recordSet = true;
+        }
+        else if (strcmp(argv[a], "--snapshots") == 0)
+        {
+#ifdef __linux__
+            return PrintSnapshots(argv[1]);
+#else
+            fprintf(stderr, "Snapshots are not supported on this platform\n");
+            return 1;
+#endif
+        }
+    }
+
+    // Load the executable call frame information, if provided
+    ElfFile elf;
+    std::shared_ptr<const CfiTable> cfiTable;
+    if (elfPath != NULL)
+    {
+        if (!elf.Load(elfPath))
+        {
+            fprintf(stderr, "Cannot load ELF file %s\n", elfPath);
+            return 1;
+        }
+
+        cfiTable = CfiTable::Get(elf);
+        if (!cfiTable)
+            fprintf(stderr, "No .eh_frame or .debug_frame unwind information in %s\n", elfPath);
+
+        // Use the executable code section to identify return addresses
+        const ElfSection* text = elf.FindSection(".text");
+        if (text != NULL && !codeRangeSet)
+        {
+            codeBegin = (INTEGER_TYPE)(text->Address + loadBias);
+            codeEnd = (INTEGER_TYPE)(text->Address + text->Size - 1 + loadBias);
+        }
+    }
+
+    // The core dump data structure is large; don't place on the stack
+    static CoreDumpData coreDumpData;
+    size_t size;
+    if (recordSet)
+    {
+#ifdef __linux__
+        long stored = ReadStoreRecord(argv[1], recordSequence, &coreDumpData);
+        if (stored < 0)
+            return 1;
+        size = (size_t)stored;
+#else
+        (void)recordSequence;
+        fprintf(stderr, "Core dump stores are not supported on this platform\n");
+        return 1;
+#endif
+    }
+    else
+    {
+        FILE* file = fopen(argv[1], "rb");
+        if (file == NULL)
+        {
+            fprintf(stderr, "Cannot open %s\n", argv[1]);
+            return 1;
+        }
+
+        uint8_t magic[4] = {};
+        size = fread(magic, 1, sizeof(magic), file);
+        rewind(file);
+        if (size == sizeof(magic) && ReadLE32(magic) == COMPRESS_MAGIC)
+        {
+            long decompressed = ReadCompressedStream(file, &coreDumpData, sizeof(coreDumpData));
+            if (decompressed < 0)
+            {
+                fprintf(stderr, "Corrupt compressed core dump %s\n", argv[1]);
+                fclose(file);
+                return 1;
+            }
+            size = (size_t)decompressed;
+        }
+        else
+        {
+            size = fread(&coreDumpData, 1, sizeof(coreDumpData), file);
+        }
+        fclose(file);
+    }
+
+    if (size != sizeof(coreDumpData))
+    {
+        fprintf(stderr, "Core dump size mismatch. Build the decoder with the target Options.h.\n");
+        return 1;
+    }
+
+    if (coreDumpData.Key != KEY_CORE_DUMP_STORED || coreDumpData.NotKey != ~KEY_CORE_DUMP_STORED)
+    {
+        fprintf(stderr, "No core dump stored within %s\n", argv[1]);
+        return 1;
+    }
+
+    // Validate the CRC32C of the whole structure, excluding the Crc field
+    uint32_t crc = CoreDumpCrc(&coreDumpData);
+    if (crc != coreDumpData.Crc)
+        fprintf(stderr, "Warning: core dump CRC mismatch (0x%08x != 0x%08x). Data may be corrupt.\n", crc, coreDumpData.Crc);
+
+#ifdef USE_STACK_SLICE
+    CfiUnwinder unwinder(cfiTable, loadBias, CoreDumpReadMemory, &coreDumpData);
+    PrintCoreDump(&coreDumpData, elfPath != NULL ? &elf : NULL, cfiTable ? &unwinder : NULL, codeBegin, codeEnd);
+#else
+    PrintCoreDump(&coreDumpData, elfPath != NULL ? &elf : NULL, NULL, codeBegin, codeEnd);
+#endif
+
+    if (minidumpPath != NULL)
+    {
+#ifdef __linux__
+        static MinidumpWriter minidump;
+        int fd = open(minidumpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        bool written = fd >= 0 && minidump.Write(fd, &coreDumpData);
+        if (fd >= 0)
+            close(fd);
+        if (!written)
+        {
+            fprintf(stderr, "Cannot write minidump %s\n", minidumpPath);
+            return 1;
+        }
+#else
+        fprintf(stderr, "Minidump output is not supported on this platform\n");
+        return 1;
+#endif
+    }
+
+    if (corePath != NULL)
+    {
+#ifdef __linux__
+        static ElfCoreWriter core;
+        int fd = open(corePath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        bool written = fd >= 0 && core.Write(fd, &coreDumpData);
+        if (fd >= 0)
+            close(fd);
+        if (!written)
+        {
+            fprintf(stderr, "Cannot write ELF core %s\n", corePath);
+            return 1;
+        }
+#else
+        fprintf(stderr, "ELF core output is not supported on this platform\n");
+        return 1;
+#endif
+    }
+    return 0;
+}
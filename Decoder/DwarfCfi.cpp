@@ -0,0 +1,814 @@
+#include "DwarfCfi.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+
+// DWARF call frame instructions
+#define DW_CFA_advance_loc          0x40
+#define DW_CFA_offset               0x80
+#define DW_CFA_restore              0xC0
+#define DW_CFA_nop                  0x00
+#define DW_CFA_set_loc              0x01
+#define DW_CFA_advance_loc1         0x02
+#define DW_CFA_advance_loc2         0x03
+#define DW_CFA_advance_loc4         0x04
+#define DW_CFA_offset_extended      0x05
+#define DW_CFA_restore_extended     0x06
+#define DW_CFA_undefined            0x07
+#define DW_CFA_same_value           0x08
+#define DW_CFA_register             0x09
+#define DW_CFA_remember_state       0x0A
+#define DW_CFA_restore_state        0x0B
+#define DW_CFA_def_cfa              0x0C
+#define DW_CFA_def_cfa_register     0x0D
+#define DW_CFA_def_cfa_offset       0x0E
+#define DW_CFA_def_cfa_expression   0x0F
+#define DW_CFA_expression           0x10
+#define DW_CFA_offset_extended_sf   0x11
+#define DW_CFA_def_cfa_sf           0x12
+#define DW_CFA_def_cfa_offset_sf    0x13
+#define DW_CFA_val_offset           0x14
+#define DW_CFA_val_offset_sf        0x15
+#define DW_CFA_val_expression       0x16
+#define DW_CFA_AARCH64_negate_ra_state  0x2D
+#define DW_CFA_GNU_args_size        0x2E
+#define DW_CFA_GNU_negative_offset_extended 0x2F
+
+// .eh_frame pointer encodings
+#define DW_EH_PE_absptr     0x00
+#define DW_EH_PE_uleb128    0x01
+#define DW_EH_PE_udata2     0x02
+#define DW_EH_PE_udata4     0x03
+#define DW_EH_PE_udata8     0x04
+#define DW_EH_PE_sleb128    0x09
+#define DW_EH_PE_sdata2     0x0A
+#define DW_EH_PE_sdata4     0x0B
+#define DW_EH_PE_sdata8     0x0C
+#define DW_EH_PE_pcrel      0x10
+#define DW_EH_PE_indirect   0x80
+#define DW_EH_PE_omit       0xFF
+
+// Maximum DW_CFA_remember_state nesting and expression stack depth
+#define CFI_STATE_STACK_DEPTH   8
+#define CFI_EXPR_STACK_DEPTH    32
+
+// Bounds checked little-endian reader over a byte range
+class CfiReader
+{
+public:
+    CfiReader(const uint8_t* begin, const uint8_t* end, uint64_t address) :
+        m_pos(begin), m_begin(begin), m_end(end), m_address(address) {}
+
+    bool Ok() const { return m_ok; }
+    bool AtEnd() const { return m_pos >= m_end; }
+    const uint8_t* Pos() const { return m_pos; }
+    void Seek(const uint8_t* pos) { m_ok = m_ok && pos >= m_begin && pos <= m_end; m_pos = pos; }
+
+    // Link-time address of the current read position
+    uint64_t Address() const { return m_address + (uint64_t)(m_pos - m_begin); }
+
+    uint64_t Unsigned(int size)
+    {
+        uint64_t value = 0;
+        if (m_end - m_pos < size)
+        {
+            m_ok = false;
+            m_pos = m_end;
+            return 0;
+        }
+        for (int b = size - 1; b >= 0; b--)
+            value = (value << 8) | m_pos[b];
+        m_pos += size;
+        return value;
+    }
+
+    int64_t Signed(int size)
+    {
+        uint64_t value = Unsigned(size);
+        int shift = 64 - size * 8;
+        return shift > 0 ? (int64_t)(value << shift) >> shift : (int64_t)value;
+    }
+
+    uint64_t Uleb128()
+    {
+        uint64_t value = 0;
+        int shift = 0;
+        while (m_pos < m_end)
+        {
+            uint8_t byte = *m_pos++;
+            if (shift < 64)
+                value |= (uint64_t)(byte & 0x7F) << shift;
+            shift += 7;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+        m_ok = false;
+        return value;
+    }
+
+    int64_t Sleb128()
+    {
+        int64_t value = 0;
+        int shift = 0;
+        while (m_pos < m_end)
+        {
+            uint8_t byte = *m_pos++;
+            if (shift < 64)
+                value |= (int64_t)(byte & 0x7F) << shift;
+            shift += 7;
+            if ((byte & 0x80) == 0)
+            {
+                if (shift < 64 && (byte & 0x40))
+                    value |= -((int64_t)1 << shift);
+                return value;
+            }
+        }
+        m_ok = false;
+        return value;
+    }
+
+    // Read a pointer stored using an .eh_frame pointer encoding
+    uint64_t Encoded(uint8_t encoding, int addressSize)
+    {
+        if (encoding == DW_EH_PE_omit)
+            return 0;
+
+        uint64_t fieldAddress = Address();
+        uint64_t value = 0;
+        switch (encoding & 0x0F)
+        {
+        case DW_EH_PE_absptr:  value = Unsigned(addressSize); break;
+        case DW_EH_PE_uleb128: value = Uleb128(); break;
+        case DW_EH_PE_udata2:  value = Unsigned(2); break;
+        case DW_EH_PE_udata4:  value = Unsigned(4); break;
+        case DW_EH_PE_udata8:  value = Unsigned(8); break;
+        case DW_EH_PE_sleb128: value = (uint64_t)Sleb128(); break;
+        case DW_EH_PE_sdata2:  value = (uint64_t)Signed(2); break;
+        case DW_EH_PE_sdata4:  value = (uint64_t)Signed(4); break;
+        case DW_EH_PE_sdata8:  value = (uint64_t)Signed(8); break;
+        default: m_ok = false; return 0;
+        }
+
+        // Only absolute and PC relative encodings are used by FDEs in practice
+        if ((encoding & 0x70) == DW_EH_PE_pcrel)
+            value += fieldAddress;
+        else if ((encoding & 0x70) != 0)
+            m_ok = false;
+
+        if (addressSize == 4)
+            value &= 0xFFFFFFFF;
+        return value;
+    }
+
+private:
+    const uint8_t* m_pos;
+    const uint8_t* m_begin;
+    const uint8_t* m_end;
+    uint64_t m_address;
+    bool m_ok = true;
+};
+
+//----------------------------------------------------------------------------
+// CfiTable
+//----------------------------------------------------------------------------
+
+std::shared_ptr<const CfiTable> CfiTable::Get(const ElfFile& elf)
+{
+    static std::mutex cacheLock;
+    static std::map<std::string, std::shared_ptr<const CfiTable>> cache;
+
+    std::string key = elf.BuildId().empty() ? elf.Path() : elf.BuildId();
+
+    std::lock_guard<std::mutex> lock(cacheLock);
+    auto it = cache.find(key);
+    if (it != cache.end())
+        return it->second;
+
+    std::shared_ptr<CfiTable> table = std::make_shared<CfiTable>();
+    table->m_machine = elf.Machine();
+    table->m_addressSize = elf.AddressSize();
+
+    // Copy the sections so the table is independent of the ElfFile lifetime
+    const ElfSection* ehFrame = elf.FindSection(".eh_frame");
+    const ElfSection* debugFrame = elf.FindSection(".debug_frame");
+    if (ehFrame != NULL && ehFrame->Data != NULL)
+    {
+        table->m_ehFrame.assign(ehFrame->Data, ehFrame->Data + ehFrame->Size);
+        ElfSection copy = *ehFrame;
+        copy.Data = table->m_ehFrame.data();
+        table->Parse(copy, true);
+    }
+    if (debugFrame != NULL && debugFrame->Data != NULL)
+    {
+        table->m_debugFrame.assign(debugFrame->Data, debugFrame->Data + debugFrame->Size);
+        ElfSection copy = *debugFrame;
+        copy.Data = table->m_debugFrame.data();
+        table->Parse(copy, false);
+    }
+
+    if (table->m_fdes.empty())
+        table.reset();
+    else
+    {
+        std::sort(table->m_fdes.begin(), table->m_fdes.end(),
+            [](const CfiFde& a, const CfiFde& b) { return a.PcBegin < b.PcBegin; });
+    }
+
+    cache[key] = table;
+    return table;
+}
+
+bool CfiTable::Parse(const ElfSection& section, bool isEhFrame)
+{
+    const uint8_t* begin = section.Data;
+    const uint8_t* end = section.Data + section.Size;
+    std::map<uint64_t, uint32_t> cieOffsets;
+
+    CfiReader reader(begin, end, section.Address);
+    while (!reader.AtEnd() && reader.Ok())
+    {
+        const uint8_t* entry = reader.Pos();
+        uint64_t length = reader.Unsigned(4);
+        bool is64 = false;
+        if (length == 0xFFFFFFFF)
+        {
+            length = reader.Unsigned(8);
+            is64 = true;
+        }
+        if (length == 0)
+        {
+            // Zero terminator within .eh_frame; otherwise skip the padding
+            if (isEhFrame)
+                break;
+            continue;
+        }
+
+        const uint8_t* idField = reader.Pos();
+        if (length > (uint64_t)(end - idField))
+            return false;
+        const uint8_t* entryEnd = idField + length;
+        CfiReader body(idField, entryEnd, reader.Address());
+        uint64_t id = body.Unsigned(is64 ? 8 : 4);
+
+        bool isCie = isEhFrame ? id == 0 : id == (is64 ? ~0ull : 0xFFFFFFFFull);
+        if (isCie)
+        {
+            CfiCie cie = {};
+            cie.AddressSize = (uint8_t)m_addressSize;
+            cie.FdeEncoding = DW_EH_PE_absptr;
+            uint8_t version = (uint8_t)body.Unsigned(1);
+            const char* augmentation = (const char*)body.Pos();
+            size_t augLen = strnlen(augmentation, (size_t)(entryEnd - body.Pos()));
+            body.Seek(body.Pos() + augLen + 1);
+            if (version >= 4)
+            {
+                cie.AddressSize = (uint8_t)body.Unsigned(1);
+                body.Unsigned(1);   // segment selector size
+            }
+            cie.CodeAlign = body.Uleb128();
+            cie.DataAlign = body.Sleb128();
+            cie.ReturnAddressRegister = version == 1 ? (uint32_t)body.Unsigned(1) : (uint32_t)body.Uleb128();
+
+            if (augLen > 0 && augmentation[0] == 'z')
+            {
+                cie.Augmented = true;
+                uint64_t augDataLen = body.Uleb128();
+                const uint8_t* augDataEnd = body.Pos() + augDataLen;
+                for (size_t a = 1; a < augLen && body.Ok(); a++)
+                {
+                    switch (augmentation[a])
+                    {
+                    case 'R': cie.FdeEncoding = (uint8_t)body.Unsigned(1); break;
+                    case 'L': body.Unsigned(1); break;
+                    case 'P': body.Encoded((uint8_t)body.Unsigned(1), cie.AddressSize); break;
+                    case 'S': cie.SignalFrame = true; break;
+                    default: break;
+                    }
+                }
+                body.Seek(augDataEnd);
+            }
+            else if (augLen > 0 && strcmp(augmentation, "eh") != 0)
+            {
+                // Unknown augmentation; the CIE cannot be interpreted
+                reader.Seek(entryEnd);
+                continue;
+            }
+
+            if (body.Ok())
+            {
+                cie.Instructions = body.Pos();
+                cie.InstructionsLen = (size_t)(entryEnd - body.Pos());
+                cieOffsets[(uint64_t)(entry - begin)] = (uint32_t)m_cies.size();
+                m_cies.push_back(cie);
+            }
+        }
+        else
+        {
+            // Locate the owning CIE. Within .eh_frame the id is a relative 
+            // offset back to the CIE; within .debug_frame a section offset.
+            uint64_t cieOffset = isEhFrame ? (uint64_t)(idField - begin) - id : id;
+            auto it = cieOffsets.find(cieOffset);
+            if (it != cieOffsets.end())
+            {
+                const CfiCie& cie = m_cies[it->second];
+                CfiFde fde = {};
+                fde.Cie = it->second;
+                if (isEhFrame)
+                {
+                    fde.PcBegin = body.Encoded(cie.FdeEncoding, cie.AddressSize);
+                    fde.PcEnd = fde.PcBegin + body.Encoded(cie.FdeEncoding & 0x0F, cie.AddressSize);
+                }
+                else
+                {
+                    fde.PcBegin = body.Unsigned(cie.AddressSize);
+                    fde.PcEnd = fde.PcBegin + body.Unsigned(cie.AddressSize);
+                }
+
+                // Skip the augmentation data (e.g. LSDA pointer) for 'z' CIEs
+                if (cie.Augmented)
+                {
+                    uint64_t augDataLen = body.Uleb128();
+                    body.Seek(body.Pos() + augDataLen);
+                }
+
+                if (body.Ok() && fde.PcBegin != 0 && fde.PcEnd > fde.PcBegin)
+                {
+                    fde.Instructions = body.Pos();
+                    fde.InstructionsLen = (size_t)(entryEnd - body.Pos());
+                    m_fdes.push_back(fde);
+                }
+            }
+        }
+
+        reader.Seek(entryEnd);
+    }
+    return reader.Ok();
+}
+
+const CfiFde* CfiTable::Find(uint64_t pc) const
+{
+    auto it = std::upper_bound(m_fdes.begin(), m_fdes.end(), pc,
+        [](uint64_t value, const CfiFde& fde) { return value < fde.PcBegin; });
+    if (it == m_fdes.begin())
+        return NULL;
+    --it;
+    return pc < it->PcEnd ? &*it : NULL;
+}
+
+//----------------------------------------------------------------------------
+// CfiUnwinder
+//----------------------------------------------------------------------------
+
+// Register recovery rules
+enum CfiRuleType
+{
+    RULE_SAME_VALUE,
+    RULE_UNDEFINED,
+    RULE_OFFSET,            // Saved at CFA + offset
+    RULE_VAL_OFFSET,        // Value is CFA + offset
+    RULE_REGISTER,          // Saved in another register
+    RULE_EXPRESSION,        // Saved at the address computed by an expression
+    RULE_VAL_EXPRESSION     // Value computed by an expression
+};
+
+struct CfiRule
+{
+    uint8_t Type;
+    int64_t Offset;         // Offset, or register number for RULE_REGISTER
+    const uint8_t* Expr;
+    size_t ExprLen;
+};
+
+// The unwind rules for one instruction address
+struct CfiState
+{
+    uint32_t CfaRegister;
+    int64_t CfaOffset;
+    const uint8_t* CfaExpr;
+    size_t CfaExprLen;
+    CfiRule Rules[CFI_REGISTER_CNT];
+};
+
+// Execute call frame instructions until the location passes targetPc
+static bool Execute(const uint8_t* instr, size_t len, const CfiCie& cie, uint64_t loc,
+    uint64_t targetPc, CfiState& state, const CfiState* initial)
+{
+    CfiState stateStack[CFI_STATE_STACK_DEPTH];
+    int stateDepth = 0;
+    CfiReader reader(instr, instr + len, 0);
+
+    while (!reader.AtEnd() && reader.Ok())
+    {
+        uint8_t op = (uint8_t)reader.Unsigned(1);
+        uint64_t reg = 0;
+        uint64_t advance = 0;
+
+        switch (op & 0xC0)
+        {
+        case DW_CFA_advance_loc:
+            advance = op & 0x3F;
+            break;
+        case DW_CFA_offset:
+            reg = op & 0x3F;
+            if (reg < CFI_REGISTER_CNT)
+            {
+                state.Rules[reg].Type = RULE_OFFSET;
+                state.Rules[reg].Offset = (int64_t)reader.Uleb128() * cie.DataAlign;
+            }
+            else
+                reader.Uleb128();
+            continue;
+        case DW_CFA_restore:
+            reg = op & 0x3F;
+            if (reg < CFI_REGISTER_CNT && initial != NULL)
+                state.Rules[reg] = initial->Rules[reg];
+            continue;
+        default:
+            break;
+        }
+
+        if ((op & 0xC0) == DW_CFA_advance_loc)
+        {
+            loc += advance * cie.CodeAlign;
+            if (loc > targetPc)
+                return true;
+            continue;
+        }
+
+        int64_t offset = 0;
+        switch (op)
+        {
+        case DW_CFA_nop:
+            break;
+        case DW_CFA_set_loc:
+            loc = reader.Encoded(cie.FdeEncoding, cie.AddressSize);
+            if (loc > targetPc)
+                return true;
+            break;
+        case DW_CFA_advance_loc1:
+        case DW_CFA_advance_loc2:
+        case DW_CFA_advance_loc4:
+            advance = reader.Unsigned(op == DW_CFA_advance_loc1 ? 1 : op == DW_CFA_advance_loc2 ? 2 : 4);
+            loc += advance * cie.CodeAlign;
+            if (loc > targetPc)
+                return true;
+            break;
+        case DW_CFA_offset_extended:
+        case DW_CFA_offset_extended_sf:
+        case DW_CFA_val_offset:
+        case DW_CFA_val_offset_sf:
+        case DW_CFA_GNU_negative_offset_extended:
+            reg = reader.Uleb128();
+            if (op == DW_CFA_offset_extended_sf || op == DW_CFA_val_offset_sf)
+                offset = reader.Sleb128() * cie.DataAlign;
+            else if (op == DW_CFA_GNU_negative_offset_extended)
+                offset = -(int64_t)reader.Uleb128() * cie.DataAlign;
+            else
+                offset = (int64_t)reader.Uleb128() * cie.DataAlign;
+            if (reg < CFI_REGISTER_CNT)
+            {
+                state.Rules[reg].Type = (op == DW_CFA_val_offset || op == DW_CFA_val_offset_sf) ?
+                    RULE_VAL_OFFSET : RULE_OFFSET;
+                state.Rules[reg].Offset = offset;
+            }
+            break;
+        case DW_CFA_restore_extended:
+            reg = reader.Uleb128();
+            if (reg < CFI_REGISTER_CNT && initial != NULL)
+                state.Rules[reg] = initial->Rules[reg];
+            break;
+        case DW_CFA_undefined:
+        case DW_CFA_same_value:
+            reg = reader.Uleb128();
+            if (reg < CFI_REGISTER_CNT)
+                state.Rules[reg].Type = op == DW_CFA_undefined ? RULE_UNDEFINED : RULE_SAME_VALUE;
+            break;
+        case DW_CFA_register:
+            reg = reader.Uleb128();
+            offset = (int64_t)reader.Uleb128();
+            if (reg < CFI_REGISTER_CNT)
+            {
+                state.Rules[reg].Type = RULE_REGISTER;
+                state.Rules[reg].Offset = offset;
+            }
+            break;
+        case DW_CFA_remember_state:
+            if (stateDepth >= CFI_STATE_STACK_DEPTH)
+                return false;
+            stateStack[stateDepth++] = state;
+            break;
+        case DW_CFA_restore_state:
+            if (stateDepth == 0)
+                return false;
+            {
+                // The CFA rule is not part of the remembered register state
+                uint32_t cfaRegister = state.CfaRegister;
+                int64_t cfaOffset = state.CfaOffset;
+                const uint8_t* cfaExpr = state.CfaExpr;
+                size_t cfaExprLen = state.CfaExprLen;
+                state = stateStack[--stateDepth];
+                state.CfaRegister = cfaRegister;
+                state.CfaOffset = cfaOffset;
+                state.CfaExpr = cfaExpr;
+                state.CfaExprLen = cfaExprLen;
+            }
+            break;
+        case DW_CFA_def_cfa:
+        case DW_CFA_def_cfa_sf:
+            state.CfaRegister = (uint32_t)reader.Uleb128();
+            state.CfaOffset = op == DW_CFA_def_cfa ? (int64_t)reader.Uleb128() : reader.Sleb128() * cie.DataAlign;
+            state.CfaExpr = NULL;
+            break;
+        case DW_CFA_def_cfa_register:
+            state.CfaRegister = (uint32_t)reader.Uleb128();
+            state.CfaExpr = NULL;
+            break;
+        case DW_CFA_def_cfa_offset:
+            state.CfaOffset = (int64_t)reader.Uleb128();
+            break;
+        case DW_CFA_def_cfa_offset_sf:
+            state.CfaOffset = reader.Sleb128() * cie.DataAlign;
+            break;
+        case DW_CFA_def_cfa_expression:
+            state.CfaExprLen = (size_t)reader.Uleb128();
+            state.CfaExpr = reader.Pos();
+            reader.Seek(reader.Pos() + state.CfaExprLen);
+            break;
+        case DW_CFA_expression:
+        case DW_CFA_val_expression:
+            reg = reader.Uleb128();
+            {
+                size_t exprLen = (size_t)reader.Uleb128();
+                if (reg < CFI_REGISTER_CNT)
+                {
+                    state.Rules[reg].Type = op == DW_CFA_expression ? RULE_EXPRESSION : RULE_VAL_EXPRESSION;
+                    state.Rules[reg].Expr = reader.Pos();
+                    state.Rules[reg].ExprLen = exprLen;
+                }
+                reader.Seek(reader.Pos() + exprLen);
+            }
+            break;
+        case DW_CFA_GNU_args_size:
+            reader.Uleb128();
+            break;
+        case DW_CFA_AARCH64_negate_ra_state:
+            // Pointer authentication signing state; the stored return 
+            // address is stripped when read if required by the target.
+            break;
+        default:
+            return false;
+        }
+    }
+    return reader.Ok();
+}
+
+CfiUnwinder::CfiUnwinder(std::shared_ptr<const CfiTable> table, uint64_t loadBias,
+    CfiReadMemory readMemory, void* context) :
+    m_table(table), m_loadBias(loadBias), m_readMemory(readMemory), m_context(context)
+{
+    switch (table ? table->Machine() : 0)
+    {
+    case ELF_MACHINE_X86_64: m_spRegister = 7;  m_pcRegister = 16; break;
+    case ELF_MACHINE_AARCH64: m_spRegister = 31; m_pcRegister = 32; break;
+    case ELF_MACHINE_386: m_spRegister = 4;  m_pcRegister = 8; break;
+    default: m_spRegister = 13; m_pcRegister = 15; break;
+    }
+}
+
+bool CfiUnwinder::Evaluate(const uint8_t* expr, size_t len, const CfiRegisters& regs,
+    bool pushCfa, uint64_t cfa, uint64_t* result)
+{
+    uint64_t stack[CFI_EXPR_STACK_DEPTH];
+    int depth = 0;
+    const int addressSize = m_table->AddressSize();
+    CfiReader reader(expr, expr + len, 0);
+
+    if (pushCfa)
+        stack[depth++] = cfa;
+
+    while (!reader.AtEnd() && reader.Ok())
+    {
+        uint8_t op = (uint8_t)reader.Unsigned(1);
+        uint64_t a = 0, b = 0;
+
+        // Operators that pop operands require enough stack entries
+        if (depth >= CFI_EXPR_STACK_DEPTH - 1)
+            return false;
+
+        if (op >= 0x30 && op <= 0x4F)           // DW_OP_lit0..31
+            stack[depth++] = op - 0x30;
+        else if (op >= 0x70 && op <= 0x8F)      // DW_OP_breg0..31
+        {
+            uint32_t reg = op - 0x70;
+            int64_t offset = reader.Sleb128();
+            if (!regs.Valid[reg])
+                return false;
+            stack[depth++] = regs.Value[reg] + (uint64_t)offset;
+        }
+        else
+        {
+            switch (op)
+            {
+            case 0x03: stack[depth++] = reader.Unsigned(addressSize); break;     // addr
+            case 0x08: stack[depth++] = reader.Unsigned(1); break;               // const1u
+            case 0x09: stack[depth++] = (uint64_t)reader.Signed(1); break;       // const1s
+            case 0x0A: stack[depth++] = reader.Unsigned(2); break;               // const2u
+            case 0x0B: stack[depth++] = (uint64_t)reader.Signed(2); break;       // const2s
+            case 0x0C: stack[depth++] = reader.Unsigned(4); break;               // const4u
+            case 0x0D: stack[depth++] = (uint64_t)reader.Signed(4); break;       // const4s
+            case 0x0E: stack[depth++] = reader.Unsigned(8); break;               // const8u
+            case 0x0F: stack[depth++] = (uint64_t)reader.Signed(8); break;       // const8s
+            case 0x10: stack[depth++] = reader.Uleb128(); break;                 // constu
+            case 0x11: stack[depth++] = (uint64_t)reader.Sleb128(); break;       // consts
+            case 0x12:                                                          // dup
+                if (depth < 1) return false;
+                stack[depth] = stack[depth - 1]; depth++;
+                break;
+            case 0x13:                                                          // drop
+                if (depth < 1) return false;
+                depth--;
+                break;
+            case 0x14:                                                          // over
+                if (depth < 2) return false;
+                stack[depth] = stack[depth - 2]; depth++;
+                break;
+            case 0x16:                                                          // swap
+                if (depth < 2) return false;
+                std::swap(stack[depth - 1], stack[depth - 2]);
+                break;
+            case 0x06:                                                          // deref
+            case 0x94:                                                          // deref_size
+            {
+                int size = op == 0x06 ? addressSize : (int)reader.Unsigned(1);
+                if (depth < 1 || size < 1 || size > 8 || 
+                    !m_readMemory(m_context, stack[depth - 1], size, &stack[depth - 1]))
+                    return false;
+                break;
+            }
+            case 0x1F:                                                          // neg
+            case 0x20:                                                          // not
+                if (depth < 1) return false;
+                stack[depth - 1] = op == 0x1F ? (uint64_t)-(int64_t)stack[depth - 1] : ~stack[depth - 1];
+                break;
+            case 0x23:                                                          // plus_uconst
+                if (depth < 1) return false;
+                stack[depth - 1] += reader.Uleb128();
+                break;
+            case 0x92:                                                          // bregx
+            {
+                uint64_t reg = reader.Uleb128();
+                int64_t offset = reader.Sleb128();
+                if (reg >= CFI_REGISTER_CNT || !regs.Valid[reg])
+                    return false;
+                stack[depth++] = regs.Value[reg] + (uint64_t)offset;
+                break;
+            }
+            case 0x96:                                                          // nop
+                break;
+            default:
+                // Binary operators
+                if (depth < 2)
+                    return false;
+                b = stack[--depth];
+                a = stack[depth - 1];
+                switch (op)
+                {
+                case 0x1A: a = a & b; break;                                    // and
+                case 0x1C: a = a - b; break;                                    // minus
+                case 0x1E: a = a * b; break;                                    // mul
+                case 0x21: a = a | b; break;                                    // or
+                case 0x22: a = a + b; break;                                    // plus
+                case 0x24: a = b < 64 ? a << b : 0; break;                      // shl
+                case 0x25: a = b < 64 ? a >> b : 0; break;                      // shr
+                case 0x26: a = (uint64_t)((int64_t)a >> (b < 64 ? b : 63)); break; // shra
+                case 0x27: a = a ^ b; break;                                    // xor
+                case 0x29: a = (int64_t)a == (int64_t)b; break;                 // eq
+                case 0x2A: a = (int64_t)a >= (int64_t)b; break;                 // ge
+                case 0x2B: a = (int64_t)a > (int64_t)b; break;                  // gt
+                case 0x2C: a = (int64_t)a <= (int64_t)b; break;                 // le
+                case 0x2D: a = (int64_t)a < (int64_t)b; break;                  // lt
+                case 0x2E: a = (int64_t)a != (int64_t)b; break;                 // ne
+                default: return false;
+                }
+                stack[depth - 1] = a;
+                break;
+            }
+        }
+    }
+
+    if (!reader.Ok() || depth < 1)
+        return false;
+    *result = stack[depth - 1];
+    return true;
+}
+
+bool CfiUnwinder::Step(CfiRegisters& regs, bool isFirstFrame, uint64_t* cfa)
+{
+    if (!m_table || !regs.Valid[m_pcRegister])
+        return false;
+
+    // A return address points after the call; look up the call instruction
+    uint64_t pc = regs.Value[m_pcRegister] - m_loadBias;
+    if (!isFirstFrame)
+        pc--;
+
+    const CfiFde* fde = m_table->Find(pc);
+    if (fde == NULL)
+        return false;
+    const CfiCie& cie = m_table->Cie(fde->Cie);
+
+    // Run the CIE initial instructions, then the FDE instructions up to the PC
+    CfiState initial, state;
+    memset(&initial, 0, sizeof(initial));
+    if (!Execute(cie.Instructions, cie.InstructionsLen, cie, fde->PcBegin, ~0ull, initial, NULL))
+        return false;
+    state = initial;
+    if (!Execute(fde->Instructions, fde->InstructionsLen, cie, fde->PcBegin, pc, state, &initial))
+        return false;
+
+    // Compute the canonical frame address
+    uint64_t frameAddress = 0;
+    if (state.CfaExpr != NULL)
+    {
+        if (!Evaluate(state.CfaExpr, state.CfaExprLen, regs, false, 0, &frameAddress))
+            return false;
+    }
+    else
+    {
+        if (state.CfaRegister >= CFI_REGISTER_CNT || !regs.Valid[state.CfaRegister])
+            return false;
+        frameAddress = regs.Value[state.CfaRegister] + (uint64_t)state.CfaOffset;
+    }
+    if (m_table->AddressSize() == 4)
+        frameAddress &= 0xFFFFFFFF;
+
+    // Recover the caller's registers
+    CfiRegisters caller = regs;
+    for (int r = 0; r < CFI_REGISTER_CNT; r++)
+    {
+        const CfiRule& rule = state.Rules[r];
+        uint64_t address = 0;
+        switch (rule.Type)
+        {
+        case RULE_SAME_VALUE:
+            break;
+        case RULE_UNDEFINED:
+            caller.Valid[r] = false;
+            break;
+        case RULE_OFFSET:
+            caller.Valid[r] = m_readMemory(m_context, frameAddress + (uint64_t)rule.Offset,
+                m_table->AddressSize(), &caller.Value[r]);
+            break;
+        case RULE_VAL_OFFSET:
+            caller.Value[r] = frameAddress + (uint64_t)rule.Offset;
+            caller.Valid[r] = true;
+            break;
+        case RULE_REGISTER:
+            caller.Valid[r] = rule.Offset < CFI_REGISTER_CNT && regs.Valid[rule.Offset];
+            caller.Value[r] = caller.Valid[r] ? regs.Value[rule.Offset] : 0;
+            break;
+        case RULE_EXPRESSION:
+            caller.Valid[r] = Evaluate(rule.Expr, rule.ExprLen, regs, true, frameAddress, &address) &&
+                m_readMemory(m_context, address, m_table->AddressSize(), &caller.Value[r]);
+            break;
+        case RULE_VAL_EXPRESSION:
+            caller.Valid[r] = Evaluate(rule.Expr, rule.ExprLen, regs, true, frameAddress, &caller.Value[r]);
+            break;
+        }
+    }
+
+    // The caller resumes at the return address with SP equal to the CFA
+    uint32_t raRegister = cie.ReturnAddressRegister;
+    if (raRegister >= CFI_REGISTER_CNT)
+        return false;
+
+    // An undefined return address marks the outermost frame, e.g. _start
+    if (state.Rules[raRegister].Type == RULE_UNDEFINED)
+    {
+        regs.Value[m_pcRegister] = 0;
+        regs.Valid[m_pcRegister] = false;
+        *cfa = frameAddress;
+        return true;
+    }
+    if (!caller.Valid[raRegister] || caller.Value[raRegister] == 0)
+        return false;
+
+    uint64_t returnAddress = caller.Value[raRegister];
+    if (m_table->Machine() == ELF_MACHINE_ARM)
+        returnAddress &= ~1ull;     // Clear the Thumb state bit
+
+    // Stop if the unwind makes no progress, e.g. a corrupt stack
+    if (frameAddress <= regs.Value[m_spRegister] && returnAddress == regs.Value[m_pcRegister])
+        return false;
+
+    caller.Value[m_pcRegister] = returnAddress;
+    caller.Valid[m_pcRegister] = true;
+    caller.Value[m_spRegister] = frameAddress;
+    caller.Valid[m_spRegister] = true;
+
+    regs = caller;
+    *cfa = frameAddress;
+    return true;
+}
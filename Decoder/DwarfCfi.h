@@ -0,0 +1,122 @@
+#ifndef _DWARF_CFI_H
+#define _DWARF_CFI_H
+
+#include "ElfFile.h"
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+// Number of DWARF registers tracked while unwinding. Large enough to cover 
+// the AArch64 callee-saved vector registers (DWARF 72-79).
+#define CFI_REGISTER_CNT    128
+
+/// A register set used to unwind. Registers use DWARF register numbering.
+struct CfiRegisters
+{
+    uint64_t Value[CFI_REGISTER_CNT];
+    bool Valid[CFI_REGISTER_CNT];
+};
+
+/// Reads target memory while unwinding, e.g. from a captured stack slice.
+/// @param[in] context - the caller supplied context
+/// @param[in] address - the target address to read
+/// @param[in] size - the number of bytes to read (1, 2, 4 or 8)
+/// @param[out] value - the little-endian value read
+/// @return Returns true if the memory is available.
+typedef bool (*CfiReadMemory)(void* context, uint64_t address, int size, uint64_t* value);
+
+/// A parsed Common Information Entry
+struct CfiCie
+{
+    uint64_t CodeAlign;
+    int64_t DataAlign;
+    uint32_t ReturnAddressRegister;
+    uint8_t FdeEncoding;
+    uint8_t AddressSize;
+    bool Augmented;         // Augmentation string starts with 'z'
+    bool SignalFrame;
+    const uint8_t* Instructions;
+    size_t InstructionsLen;
+};
+
+/// A parsed Frame Description Entry
+struct CfiFde
+{
+    uint64_t PcBegin;       // Link-time address of the first instruction
+    uint64_t PcEnd;         // Link-time address one past the last instruction
+    uint32_t Cie;           // Index of the owning CIE
+    const uint8_t* Instructions;
+    size_t InstructionsLen;
+};
+
+/// The parsed .eh_frame/.debug_frame unwind tables of one ELF build. Tables
+/// are parsed once per build-id and shared by all dumps from that build.
+class CfiTable
+{
+public:
+    /// Get the parsed unwind table of an ELF file. Parsed tables are cached 
+    /// by build-id (or path when no build-id exists).
+    /// @param[in] elf - the loaded ELF file
+    /// @return The parsed table, or nullptr if the file has no unwind tables.
+    static std::shared_ptr<const CfiTable> Get(const ElfFile& elf);
+
+    /// Find the FDE covering a link-time instruction address.
+    /// @param[in] pc - the instruction address
+    /// @return A pointer to the FDE or NULL if not found.
+    const CfiFde* Find(uint64_t pc) const;
+
+    const CfiCie& Cie(uint32_t index) const { return m_cies[index]; }
+    size_t FdeCount() const { return m_fdes.size(); }
+    int Machine() const { return m_machine; }
+    int AddressSize() const { return m_addressSize; }
+
+private:
+    bool Parse(const ElfSection& section, bool isEhFrame);
+
+    // Copies of the unwind sections. CIE/FDE instructions point into these.
+    std::vector<uint8_t> m_ehFrame;
+    std::vector<uint8_t> m_debugFrame;
+    std::vector<CfiCie> m_cies;
+    std::vector<CfiFde> m_fdes;
+    int m_machine = 0;
+    int m_addressSize = 8;
+};
+
+/// Unwinds one frame at a time by interpreting the DWARF call frame information.
+class CfiUnwinder
+{
+public:
+    /// @param[in] table - the parsed unwind table of the executable
+    /// @param[in] loadBias - runtime load address minus link-time address
+    /// @param[in] readMemory - reads target memory such as the stack slice
+    /// @param[in] context - passed to readMemory
+    CfiUnwinder(std::shared_ptr<const CfiTable> table, uint64_t loadBias,
+        CfiReadMemory readMemory, void* context);
+
+    /// Unwind one frame. On success, regs is updated to the caller's registers.
+    /// @param[in,out] regs - the current frame registers
+    /// @param[in] isFirstFrame - true if the PC is the faulting instruction 
+    ///     rather than a return address
+    /// @param[out] cfa - the canonical frame address of the unwound frame
+    /// @return Returns true if the caller frame was recovered, or if the frame
+    ///     is the outermost (an undefined return address); the caller PC is 
+    ///     then 0.
+    bool Step(CfiRegisters& regs, bool isFirstFrame, uint64_t* cfa);
+
+    /// The DWARF register numbers of the stack pointer and program counter
+    int SpRegister() const { return m_spRegister; }
+    int PcRegister() const { return m_pcRegister; }
+
+private:
+    bool Evaluate(const uint8_t* expr, size_t len, const CfiRegisters& regs, 
+        bool pushCfa, uint64_t cfa, uint64_t* result);
+
+    std::shared_ptr<const CfiTable> m_table;
+    uint64_t m_loadBias;
+    CfiReadMemory m_readMemory;
+    void* m_context;
+    int m_spRegister;
+    int m_pcRegister;
+};
+
+#endif 
@@ -0,0 +1,162 @@
+#include "ElfFile.h"
+#include <cstdio>
+#include <cstring>
+
+#define ELF_SECTION_RELA    4
+#define ELF_SECTION_NOBITS  8
+
+// Relocation types adding the load bias to the addend
+#define R_386_RELATIVE      8
+#define R_ARM_RELATIVE      23
+#define R_X86_64_RELATIVE   8
+#define R_AARCH64_RELATIVE  1027
+
+uint64_t ElfFile::Read(size_t offset, int size) const
+{
+    uint64_t value = 0;
+    if (offset + size > m_image.size())
+        return 0;
+    for (int b = size - 1; b >= 0; b--)
+        value = (value << 8) | m_image[offset + b];
+    return value;
+}
+
+bool ElfFile::Load(const char* path)
+{
+    m_path = path;
+    m_image.clear();
+    m_sections.clear();
+    m_buildId.clear();
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size > 0)
+    {
+        m_image.resize((size_t)size);
+        if (fread(m_image.data(), 1, m_image.size(), file) != m_image.size())
+            m_image.clear();
+    }
+    fclose(file);
+
+    // Only little-endian ELF files are supported
+    if (m_image.size() < 0x34 || memcmp(m_image.data(), "\x7F" "ELF", 4) != 0 || m_image[5] != 1)
+        return false;
+
+    m_is64 = m_image[4] == 2;
+    m_machine = (int)Read(0x12, 2);
+
+    uint64_t shoff = m_is64 ? Read(0x28, 8) : Read(0x20, 4);
+    uint64_t shentsize = m_is64 ? Read(0x3A, 2) : Read(0x2E, 2);
+    uint64_t shnum = m_is64 ? Read(0x3C, 2) : Read(0x30, 2);
+    uint64_t shstrndx = m_is64 ? Read(0x3E, 2) : Read(0x32, 2);
+    if (shoff == 0 || shoff + shentsize * shnum > m_image.size() || shstrndx >= shnum)
+        return false;
+
+    // Read all section headers
+    std::vector<uint64_t> nameOffsets;
+    for (uint64_t s = 0; s < shnum; s++)
+    {
+        size_t hdr = (size_t)(shoff + s * shentsize);
+        ElfSection section;
+        nameOffsets.push_back(Read(hdr, 4));
+        section.Type = (uint32_t)Read(hdr + 4, 4);
+        section.Address = m_is64 ? Read(hdr + 0x10, 8) : Read(hdr + 0x0C, 4);
+        uint64_t offset = m_is64 ? Read(hdr + 0x18, 8) : Read(hdr + 0x10, 4);
+        section.Size = m_is64 ? Read(hdr + 0x20, 8) : Read(hdr + 0x14, 4);
+        section.Data = NULL;
+        if (section.Type != ELF_SECTION_NOBITS && offset + section.Size <= m_image.size())
+            section.Data = m_image.data() + offset;
+        m_sections.push_back(section);
+    }
+
+    // Resolve the section names using the section name string table
+    const ElfSection& strtab = m_sections[(size_t)shstrndx];
+    for (size_t s = 0; s < m_sections.size(); s++)
+    {
+        if (strtab.Data != NULL && nameOffsets[s] < strtab.Size)
+        {
+            const char* name = (const char*)strtab.Data + nameOffsets[s];
+            m_sections[s].Name.assign(name, strnlen(name, (size_t)(strtab.Size - nameOffsets[s])));
+        }
+    }
+
+    // Read the GNU build-id note: namesz, descsz, type, "GNU\0", build-id bytes
+    const ElfSection* note = FindSection(".note.gnu.build-id");
+    if (note != NULL && note->Data != NULL && note->Size >= 16)
+    {
+        size_t base = (size_t)(note->Data - m_image.data());
+        uint64_t nameSize = Read(base, 4);
+        uint64_t descSize = Read(base + 4, 4);
+        uint64_t descOffset = 12 + ((nameSize + 3) & ~3ull);
+        if (descOffset + descSize <= note->Size)
+        {
+            static const char hex[] = "0123456789abcdef";
+            for (uint64_t b = 0; b < descSize; b++)
+            {
+                uint8_t value = note->Data[descOffset + b];
+                m_buildId += hex[value >> 4];
+                m_buildId += hex[value & 0xF];
+            }
+        }
+    }
+
+    return true;
+}
+
+const ElfSection* ElfFile::FindSection(const char* name) const
+{
+    for (const ElfSection& section : m_sections)
+    {
+        if (section.Name == name)
+            return &section;
+    }
+    return NULL;
+}
+
+const ElfSection* ElfFile::FindSectionByAddress(uint64_t address) const
+{
+    for (const ElfSection& section : m_sections)
+    {
+        if (section.Address != 0 && address >= section.Address && address - section.Address < section.Size)
+            return &section;
+    }
+    return NULL;
+}
+
+bool ElfFile::ReadPointer(uint64_t address, uint64_t* value) const
+{
+    const ElfSection* section = FindSectionByAddress(address);
+    int size = AddressSize();
+    if (section == NULL || section->Data == NULL || address - section->Address + size > section->Size)
+        return false;
+    *value = Read((size_t)(section->Data - m_image.data() + (address - section->Address)), size);
+
+    uint32_t relative = m_machine == ELF_MACHINE_X86_64 ? R_X86_64_RELATIVE :
+        m_machine == ELF_MACHINE_AARCH64 ? R_AARCH64_RELATIVE :
+        m_machine == ELF_MACHINE_386 ? R_386_RELATIVE : R_ARM_RELATIVE;
+
+    // Elf_Rela: offset, info, addend. SHT_REL and SHT_RELR relocations keep
+    // the addend in place.
+    for (const ElfSection& rela : m_sections)
+    {
+        if (rela.Type != ELF_SECTION_RELA || rela.Data == NULL)
+            continue;
+        size_t base = (size_t)(rela.Data - m_image.data());
+        for (uint64_t entry = 0; entry + size * 3 <= rela.Size; entry += size * 3)
+        {
+            if (Read(base + entry, size) != address)
+                continue;
+            uint64_t info = Read(base + entry + size, size);
+            uint32_t type = m_is64 ? (uint32_t)info : (uint32_t)(info & 0xFF);
+            if (type == relative)
+                *value = Read(base + entry + size * 2, size);
+            return true;
+        }
+    }
+    return true;
+}
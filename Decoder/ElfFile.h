@@ -0,0 +1,73 @@
+#ifndef _ELF_FILE_H
+#define _ELF_FILE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// ELF machine types supported by the decoder
+#define ELF_MACHINE_386         3
+#define ELF_MACHINE_ARM         40
+#define ELF_MACHINE_X86_64      62
+#define ELF_MACHINE_AARCH64     183
+
+/// A section within an ELF file
+struct ElfSection
+{
+    std::string Name;
+    uint32_t Type;
+    uint64_t Address;       // Link-time virtual address
+    uint64_t Size;
+    const uint8_t* Data;    // Section contents, or NULL for NOBITS sections
+};
+
+/// A minimal read-only little-endian ELF file reader (32 and 64-bit). Used by
+/// the decoder to locate unwind tables and the build-id of an executable.
+class ElfFile
+{
+public:
+    /// Load an ELF file into memory.
+    /// @param[in] path - the ELF executable or shared library path
+    /// @return Returns true if the file is a supported ELF file.
+    bool Load(const char* path);
+
+    /// Find a section by name.
+    /// @param[in] name - the section name, e.g. ".eh_frame"
+    /// @return A pointer to the section or NULL if not found.
+    const ElfSection* FindSection(const char* name) const;
+
+    /// Find the section holding a link-time address.
+    /// @param[in] address - the virtual address
+    /// @return A pointer to the section or NULL if not found.
+    const ElfSection* FindSectionByAddress(uint64_t address) const;
+
+    /// Read a pointer stored at a link-time address. In a position 
+    /// independent file the pointer is left to an R_*_RELATIVE dynamic 
+    /// relocation; its addend is the link-time pointer value.
+    /// @param[in] address - the virtual address of the pointer
+    /// @param[out] value - the link-time pointer value
+    /// @return True if the address is within the file contents.
+    bool ReadPointer(uint64_t address, uint64_t* value) const;
+
+    bool Is64() const { return m_is64; }
+    int AddressSize() const { return m_is64 ? 8 : 4; }
+    int Machine() const { return m_machine; }
+
+    /// The GNU build-id as a hex string, or empty if the file has none
+    const std::string& BuildId() const { return m_buildId; }
+
+    /// The file path passed to Load()
+    const std::string& Path() const { return m_path; }
+
+private:
+    uint64_t Read(size_t offset, int size) const;
+
+    std::string m_path;
+    std::vector<uint8_t> m_image;
+    std::vector<ElfSection> m_sections;
+    std::string m_buildId;
+    bool m_is64 = false;
+    int m_machine = 0;
+};
+
+#endif 
@@ -0,0 +1,159 @@
+#include "StackUnwind.h"
+#include <cstring>
+
+#ifdef USE_STACK_SLICE
+
+// Copy captured memory if the whole range lies within the captured block
+static bool ReadCaptured(const uint8_t* block, INTEGER_TYPE blockAddress, uint32_t blockLen,
+    uint64_t address, int size, uint64_t* value)
+{
+    if (address < (uint64_t)blockAddress || address - (uint64_t)blockAddress + size > blockLen)
+        return false;
+    *value = 0;
+    memcpy(value, &block[address - (uint64_t)blockAddress], size);
+    return true;
+}
+
+bool CoreDumpReadMemory(void* context, uint64_t address, int size, uint64_t* value)
+{
+    const CoreDumpData* coreDumpData = (const CoreDumpData*)context;
+
+    uint32_t length = coreDumpData->StackSliceLength;
+    if (length > STACK_SLICE_SIZE)
+        length = STACK_SLICE_SIZE;
+    if (ReadCaptured(coreDumpData->StackSlice, coreDumpData->StackSliceAddress, length, address, size, value))
+        return true;
+
+#ifdef USE_MEMORY_REGIONS
+    uint32_t regionCnt = coreDumpData->RegionCount;
+    if (regionCnt > MAX_STORED_REGIONS)
+        regionCnt = MAX_STORED_REGIONS;
+    for (uint32_t r = 0; r < regionCnt; r++)
+    {
+        const CoreDumpRegion* region = &coreDumpData->Regions[r];
+        if (region->Offset > MEMORY_REGION_BLOB_SIZE || region->Length > MEMORY_REGION_BLOB_SIZE - region->Offset)
+            continue;
+        if (ReadCaptured(&coreDumpData->RegionBlob[region->Offset], region->Address, region->Length, address, size, value))
+            return true;
+    }
+#endif
+    return false;
+}
+
+bool StackSliceRead(const CoreDumpData* coreDumpData, INTEGER_TYPE address, INTEGER_TYPE* value)
+{
+    uint32_t length = coreDumpData->StackSliceLength;
+    if (length > STACK_SLICE_SIZE)
+        length = STACK_SLICE_SIZE;
+
+    uint64_t data = 0;
+    if (!ReadCaptured(coreDumpData->StackSlice, coreDumpData->StackSliceAddress, length,
+        (uint64_t)address, sizeof(INTEGER_TYPE), &data))
+        return false;
+    *value = (INTEGER_TYPE)data;
+    return true;
+}
+
+int StackUnwind(const CoreDumpData* coreDumpData, CfiUnwinder* unwinder, INTEGER_TYPE codeBegin,
+    INTEGER_TYPE codeEnd, UnwindFrame* frames, int maxFrames)
+{
+    const INTEGER_TYPE* sliceRegs = coreDumpData->StackSliceRegisters;
+    const uint64_t mask = coreDumpData->StackSliceRegisterMask;
+    const INTEGER_TYPE wordSize = sizeof(INTEGER_TYPE);
+    int frameCnt = 0;
+
+    if (coreDumpData->StackSliceLength == 0 || maxFrames <= 0)
+        return 0;
+
+    // The register set used for CFI unwinding
+    CfiRegisters regs;
+    memset(&regs, 0, sizeof(regs));
+    for (int r = 0; r < UNWIND_REGISTER_CNT; r++)
+    {
+        regs.Valid[r] = (mask & (1ull << r)) != 0;
+        regs.Value[r] = (uint64_t)sliceRegs[r];
+    }
+
+    INTEGER_TYPE pc = regs.Valid[UNWIND_REGISTER_PC] ? sliceRegs[UNWIND_REGISTER_PC] : 0;
+    INTEGER_TYPE sp = coreDumpData->StackSliceAddress;
+    INTEGER_TYPE fp = regs.Valid[UNWIND_REGISTER_FP] ? sliceRegs[UNWIND_REGISTER_FP] : 0;
+
+    // True once the outermost frame is reached (an undefined return address)
+    bool ended = false;
+
+    while (pc != 0 && frameCnt < maxFrames)
+    {
+        UnwindFrame& frame = frames[frameCnt++];
+        frame.PC = pc;
+        frame.SP = sp;
+        frame.CFA = 0;
+        frame.Cfi = false;
+        frame.Scanned = false;
+
+        // Unwind using the call frame information when available
+        uint64_t cfa = 0;
+        if (unwinder != NULL && unwinder->Step(regs, frameCnt == 1, &cfa))
+        {
+            frame.CFA = (INTEGER_TYPE)cfa;
+            frame.Cfi = true;
+            pc = (INTEGER_TYPE)regs.Value[UNWIND_REGISTER_PC];
+            sp = (INTEGER_TYPE)cfa;
+            fp = regs.Valid[UNWIND_REGISTER_FP] ? (INTEGER_TYPE)regs.Value[UNWIND_REGISTER_FP] : 0;
+            ended = pc == 0;
+            continue;
+        }
+
+        // Otherwise follow the frame pointer chain. Each frame stores the caller
+        // frame pointer at [FP] followed by the return address at [FP + word size].
+        INTEGER_TYPE callerFp = 0, returnAddr = 0;
+        bool linked = fp >= sp && (fp % wordSize) == 0 &&
+            StackSliceRead(coreDumpData, fp, &callerFp) &&
+            StackSliceRead(coreDumpData, fp + wordSize, &returnAddr);
+        if (!linked)
+            break;
+        if (returnAddr == 0)
+        {
+            ended = true;
+            break;
+        }
+
+        frame.CFA = fp + 2 * wordSize;
+        pc = returnAddr;
+        sp = frame.CFA;
+
+        // A valid caller frame must be located higher up the stack
+        fp = callerFp > fp ? callerFp : 0;
+
+        // Only the frame pointer chain registers are known for the caller
+        memset(&regs.Valid, 0, sizeof(regs.Valid));
+        regs.Value[UNWIND_REGISTER_PC] = (uint64_t)pc;
+        regs.Valid[UNWIND_REGISTER_PC] = true;
+        regs.Value[UNWIND_REGISTER_SP] = (uint64_t)sp;
+        regs.Valid[UNWIND_REGISTER_SP] = true;
+        regs.Value[UNWIND_REGISTER_FP] = (uint64_t)fp;
+        regs.Valid[UNWIND_REGISTER_FP] = fp != 0;
+    }
+
+    // The exact unwind failed; search the remaining stack slice for return 
+    // addresses within the code range
+    INTEGER_TYPE addr = coreDumpData->StackSliceAddress;
+    if (frameCnt > 0)
+        addr = frames[frameCnt - 1].CFA != 0 ? frames[frameCnt - 1].CFA : frames[frameCnt - 1].SP;
+    INTEGER_TYPE value = 0;
+    while (!ended && frameCnt < maxFrames && codeEnd > codeBegin && StackSliceRead(coreDumpData, addr, &value))
+    {
+        if (value >= codeBegin && value <= codeEnd)
+        {
+            frames[frameCnt].PC = value;
+            frames[frameCnt].SP = addr;
+            frames[frameCnt].CFA = 0;
+            frames[frameCnt].Cfi = false;
+            frames[frameCnt].Scanned = true;
+            frameCnt++;
+        }
+        addr += wordSize;
+    }
+
+    return frameCnt;
+}
+#endif
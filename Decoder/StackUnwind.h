@@ -0,0 +1,47 @@
+#ifndef _STACK_UNWIND_H
+#define _STACK_UNWIND_H
+
+#include "CoreDump.h"
+#include "DwarfCfi.h"
+
+// Maximum number of frames rebuilt from a stack slice
+#define MAX_UNWIND_FRAMES   64
+
+/// A call stack frame rebuilt offline from a captured stack slice
+struct UnwindFrame
+{
+    INTEGER_TYPE PC;        // Instruction address within the frame function
+    INTEGER_TYPE SP;        // Lowest stack address of the frame
+    INTEGER_TYPE CFA;       // Canonical frame address (caller stack pointer)
+    bool Cfi;               // True if unwound using call frame information
+    bool Scanned;           // True if found by searching the stack slice (heuristic)
+};
+
+/// Rebuild the call stack frames from the stack slice stored within a core dump.
+/// Frames are unwound using DWARF call frame information when available. Frames
+/// without CFI are linked using the frame pointer chain. If both fail before
+/// the outermost frame (an undefined return address), the remaining stack 
+/// slice is searched for return addresses within the code range.
+/// @param[in] coreDumpData - the core dump data structure
+/// @param[in] unwinder - the CFI unwinder for the executable, or NULL
+/// @param[in] codeBegin - the first code address used to identify return addresses
+/// @param[in] codeEnd - the last code address used to identify return addresses
+/// @param[out] frames - the rebuilt frames, innermost first
+/// @param[in] maxFrames - the frames array length
+/// @return The number of frames rebuilt.
+int StackUnwind(const CoreDumpData* coreDumpData, CfiUnwinder* unwinder, INTEGER_TYPE codeBegin,
+    INTEGER_TYPE codeEnd, UnwindFrame* frames, int maxFrames);
+
+/// Read a value from the stack slice stored within a core dump.
+/// @param[in] coreDumpData - the core dump data structure
+/// @param[in] address - the original stack address to read
+/// @param[out] value - the value read
+/// @return Returns true if the address is within the stack slice.
+bool StackSliceRead(const CoreDumpData* coreDumpData, INTEGER_TYPE address, INTEGER_TYPE* value);
+
+/// CfiReadMemory callback reading target memory captured within a core dump 
+/// (the stack slice and any stored memory regions).
+/// @param[in] context - the const CoreDumpData* core dump
+bool CoreDumpReadMemory(void* context, uint64_t address, int size, uint64_t* value);
+
+#endif 
@@ -0,0 +1,327 @@
+#include "DumpStore.h"
+
+#ifdef __linux__
+
+#include "Crc32c.h"
+#include <cstring>
+#include <cstdlib>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// FNV-1a 64-bit
+#define FNV_OFFSET  0xcbf29ce484222325ull
+#define FNV_PRIME   0x100000001b3ull
+
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t length)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    return hash;
+}
+
+uint64_t DumpStackHash(const CoreDumpData* coreDumpData)
+{
+    uint64_t hash = FNV_OFFSET;
+#ifdef USE_MODULE_RELATIVE_STACK
+    for (int s = 0; s < CALL_STACK_SIZE; s++)
+    {
+        // Identify the module by build-id, or by name if it has none
+        uint8_t m = coreDumpData->ActiveCallStackModule[s];
+        if (m < coreDumpData->ModuleCount && m < MAX_STACK_MODULES)
+        {
+            const CoreDumpModule* module = &coreDumpData->Modules[m];
+            if (module->BuildIdLength != 0 && module->BuildIdLength <= BUILD_ID_LEN)
+                hash = HashBytes(hash, module->BuildId, module->BuildIdLength);
+            else
+                hash = HashBytes(hash, module->Name, strnlen(module->Name, MODULE_NAME_LEN));
+        }
+        hash = HashBytes(hash, &coreDumpData->ActiveCallStackOffset[s], sizeof(uint32_t));
+    }
+#else
+    hash = HashBytes(hash, coreDumpData->ActiveCallStack, sizeof(coreDumpData->ActiveCallStack));
+#endif
+    return hash;
+}
+
+static uint32_t RecordCrc(const DumpRecordHeader* header, const void* data)
+{
+    DumpRecordHeader copy = *header;
+    copy.Crc = 0;
+    return Crc32c(Crc32c(0, &copy, sizeof(copy)), data, header->Length);
+}
+
+DumpStore::DumpStore() :
+    m_fd(-1),
+    m_size(0),
+    m_sequence(0),
+    m_records(0),
+    m_duplicates(0),
+    m_index(NULL),
+    m_indexUsed(0),
+    m_queued(0)
+{
+}
+
+DumpStore::~DumpStore()
+{
+    Close();
+}
+
+bool DumpStore::Open(const char* path)
+{
+    Close();
+
+    m_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0)
+    {
+        Close();
+        return false;
+    }
+    m_size = st.st_size;
+
+    m_index = (uint64_t*)calloc(DUMP_STORE_INDEX_SIZE, sizeof(uint64_t));
+    if (m_index == NULL)
+    {
+        Close();
+        return false;
+    }
+
+    // Validate the existing records and rebuild the stack hash index
+    DumpRecordHeader header;
+    uint64_t offset = 0;
+    uint64_t next = 0;
+    while (Read(offset, &header, NULL, 0, &next) == DUMP_READ_OK)
+    {
+        if (!(header.Flags & DUMP_RECORD_DUPLICATE))
+            IndexInsert(header.StackHash);
+        m_sequence = header.Sequence + 1;
+        offset = next;
+    }
+
+    // Discard a torn record left by an interrupted commit
+    if (offset != m_size)
+    {
+        if (ftruncate(m_fd, offset) != 0)
+        {
+            Close();
+            return false;
+        }
+        m_size = offset;
+    }
+    return true;
+}
+
+void DumpStore::Close()
+{
+    if (m_fd >= 0)
+    {
+        Commit();
+        close(m_fd);
+        m_fd = -1;
+    }
+    free(m_index);
+    m_index = NULL;
+    m_indexUsed = 0;
+    m_queued = 0;
+    m_size = 0;
+}
+
+bool DumpStore::IndexContains(uint64_t stackHash) const
+{
+    if (stackHash == 0)
+        stackHash = 1;
+
+    uint32_t mask = DUMP_STORE_INDEX_SIZE - 1;
+    for (uint32_t slot = (uint32_t)stackHash & mask; m_index[slot] != 0; slot = (slot + 1) & mask)
+    {
+        if (m_index[slot] == stackHash)
+            return true;
+    }
+    return false;
+}
+
+bool DumpStore::IndexInsert(uint64_t stackHash)
+{
+    // Zero marks an empty slot
+    if (stackHash == 0)
+        stackHash = 1;
+
+    uint32_t mask = DUMP_STORE_INDEX_SIZE - 1;
+    for (uint32_t slot = (uint32_t)stackHash & mask; ; slot = (slot + 1) & mask)
+    {
+        if (m_index[slot] == stackHash)
+            return false;
+        if (m_index[slot] == 0)
+        {
+            // Keep the index sparse; stop deduplicating new hashes when full
+            if (m_indexUsed >= DUMP_STORE_INDEX_SIZE / 2)
+                return true;
+            m_index[slot] = stackHash;
+            m_indexUsed++;
+            return true;
+        }
+    }
+}
+
+bool DumpStore::Append(const void* data, uint32_t length, uint64_t stackHash, uint32_t flags)
+{
+    if (m_fd < 0)
+        return false;
+    if (m_queued >= DUMP_STORE_BATCH && !Commit())
+        return false;
+
+    DumpRecordHeader* header = &m_headers[m_queued];
+    header->Magic = DUMP_RECORD_MAGIC;
+    header->StackHash = stackHash;
+    header->Sequence = m_sequence++;
+    header->Flags = flags;
+    header->Length = length;
+
+    // A stack hash is indexed once its record is durable. Also match the
+    // records queued for this commit.
+    bool duplicate = IndexContains(stackHash);
+    for (int q = 0; q < m_queued && !duplicate; q++)
+        duplicate = !(m_headers[q].Flags & DUMP_RECORD_DUPLICATE) && m_headers[q].StackHash == stackHash;
+
+    if (duplicate)
+    {
+        header->Flags = DUMP_RECORD_DUPLICATE;
+        header->Length = 0;
+        m_duplicates++;
+    }
+    header->Crc = RecordCrc(header, data);
+
+    m_iov[m_queued * 2].iov_base = header;
+    m_iov[m_queued * 2].iov_len = sizeof(*header);
+    m_iov[m_queued * 2 + 1].iov_base = (void*)data;
+    m_iov[m_queued * 2 + 1].iov_len = header->Length;
+    m_queued++;
+    m_records++;
+    return true;
+}
+
+void DumpStore::DropQueued()
+{
+    // The sequence numbers are reused so the store has no gap
+    for (int q = 0; q < m_queued; q++)
+    {
+        if (m_headers[q].Flags & DUMP_RECORD_DUPLICATE)
+            m_duplicates--;
+    }
+    m_sequence -= m_queued;
+    m_records -= m_queued;
+    m_queued = 0;
+}
+
+bool DumpStore::Commit()
+{
+    if (m_fd < 0)
+        return false;
+    if (m_queued == 0)
+        return true;
+
+    // Write every queued record with as few system calls as possible
+    struct iovec* iov = m_iov;
+    int iovCnt = m_queued * 2;
+    uint64_t offset = m_size;
+    while (iovCnt > 0)
+    {
+        ssize_t written = pwritev(m_fd, iov, iovCnt, offset);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            // Drop the partial batch. The next commit overwrites it and 
+            // Open() discards any torn record.
+            DropQueued();
+            return false;
+        }
+
+        offset += written;
+        while (iovCnt > 0 && (size_t)written >= iov->iov_len)
+        {
+            written -= iov->iov_len;
+            iov++;
+            iovCnt--;
+        }
+        if (iovCnt > 0)
+        {
+            iov->iov_base = (uint8_t*)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    // One flush makes the whole batch durable. Otherwise the batch is 
+    // dropped as above.
+    if (fdatasync(m_fd) != 0)
+    {
+        DropQueued();
+        return false;
+    }
+    int queued = m_queued;
+    m_queued = 0;
+    m_size = offset;
+
+    // Only stack hashes of durable records mark later records as duplicates
+    for (int q = 0; q < queued; q++)
+    {
+        if (!(m_headers[q].Flags & DUMP_RECORD_DUPLICATE))
+            IndexInsert(m_headers[q].StackHash);
+    }
+    return true;
+}
+
+DumpReadResult DumpStore::Read(uint64_t offset, DumpRecordHeader* header, void* data, size_t capacity,
+    uint64_t* next) const
+{
+    if (m_fd < 0 || offset + sizeof(*header) > m_size)
+        return DUMP_READ_END;
+    if (pread(m_fd, header, sizeof(*header), offset) != (ssize_t)sizeof(*header))
+        return DUMP_READ_END;
+    if (header->Magic != DUMP_RECORD_MAGIC)
+        return DUMP_READ_END;
+
+    uint64_t payloadOffset = offset + sizeof(*header);
+    if (payloadOffset + header->Length > m_size)
+        return DUMP_READ_END;
+
+    DumpRecordHeader copy = *header;
+    copy.Crc = 0;
+    uint32_t crc = Crc32c(0, &copy, sizeof(copy));
+
+    // A record too large for the caller is validated and skipped
+    bool tooLarge = data != NULL && header->Length > capacity;
+    if (data != NULL && !tooLarge)
+    {
+        if (pread(m_fd, data, header->Length, payloadOffset) != (ssize_t)header->Length)
+            return DUMP_READ_END;
+        crc = Crc32c(crc, data, header->Length);
+    }
+    else
+    {
+        // Validate the payload without a caller buffer
+        uint8_t chunk[4096];
+        for (uint32_t done = 0; done < header->Length; )
+        {
+            uint32_t count = header->Length - done < sizeof(chunk) ? header->Length - done : sizeof(chunk);
+            if (pread(m_fd, chunk, count, payloadOffset + done) != (ssize_t)count)
+                return DUMP_READ_END;
+            crc = Crc32c(crc, chunk, count);
+            done += count;
+        }
+    }
+
+    if (crc != header->Crc)
+        return DUMP_READ_END;
+    *next = payloadOffset + header->Length;
+    return tooLarge ? DUMP_READ_TOO_LARGE : DUMP_READ_OK;
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef _DUMP_STORE_H
+#define _DUMP_STORE_H
+
+// Append-only core dump store. Records are queued with Append() and written
+// together by Commit() with one writev and one fdatasync (group commit). A
+// record whose stack hash is already stored is written as a header-only
+// duplicate record. A torn record at the end of the file, left by a crash
+// during a commit, is discarded on Open().
+
+#ifdef __linux__
+
+#include "CoreDump.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+#define DUMP_RECORD_MAGIC       0x52445344      // "DSDR"
+
+// Record flags
+#define DUMP_RECORD_DUPLICATE   0x0001          // Header only; stack hash stored earlier
+#define DUMP_RECORD_COMPRESSED  0x0002          // Payload is a compressed stream (Compress.h)
+
+// Maximum records queued between commits
+#define DUMP_STORE_BATCH        128
+
+// Stack hash index capacity. Must be a power of 2. Stack hashes beyond
+// capacity are stored without deduplication.
+#define DUMP_STORE_INDEX_SIZE   (64 * 1024)
+
+/// Header preceding each record payload within the store file
+struct DumpRecordHeader
+{
+    uint32_t Magic;
+    uint32_t Length;        // Payload length in bytes; 0 for a duplicate record
+    uint64_t StackHash;
+    uint64_t Sequence;      // Record number within the store
+    uint32_t Flags;
+    uint32_t Crc;           // CRC32C of the header, computed with Crc = 0, and payload
+};
+
+/// DumpStore::Read() result
+enum DumpReadResult
+{
+    DUMP_READ_OK,               // A valid record was read
+    DUMP_READ_END,              // The end of the store or a torn record
+    DUMP_READ_TOO_LARGE         // A valid record larger than the payload destination; not copied
+};
+
+/// Compute a hash of a core dump call stack used to deduplicate dumps of
+/// the same crash. Module relative call stacks hash identically across
+/// processes with different load addresses.
+/// @param[in] coreDumpData - the core dump data structure
+/// @return The 64-bit stack hash.
+uint64_t DumpStackHash(const CoreDumpData* coreDumpData);
+
+class DumpStore
+{
+public:
+    DumpStore();
+    ~DumpStore();
+
+    /// Open or create a store file. Existing records are validated and the
+    /// stack hash index rebuilt.
+    /// @param[in] path - the store file path
+    /// @return True if successful.
+    bool Open(const char* path);
+
+    /// Commit queued records and close the store file.
+    void Close();
+
+    /// Queue a record for the next Commit(). Commits first if the queue is full.
+    /// If the commit fails, the queued records are dropped and their sequence
+    /// numbers reused; records with the same stack hash are stored in full later.
+    /// @param[in] data - the record payload. Must remain valid until Commit().
+    /// @param[in] length - the payload length in bytes
+    /// @param[in] stackHash - the stack hash used for deduplication
+    /// @param[in] flags - record flags describing the payload, e.g. DUMP_RECORD_COMPRESSED
+    /// @return True if successful.
+    bool Append(const void* data, uint32_t length, uint64_t stackHash, uint32_t flags);
+
+    /// Write all queued records and make them durable.
+    /// @return True if successful.
+    bool Commit();
+
+    /// Read a record.
+    /// @param[in] offset - the record file offset; 0 is the first record
+    /// @param[out] header - the record header
+    /// @param[out] data - the record payload destination, or NULL
+    /// @param[in] capacity - the payload destination size in bytes
+    /// @param[out] next - the file offset of the following record
+    /// @return DUMP_READ_OK if a valid record was read; DUMP_READ_TOO_LARGE 
+    ///     if the record is valid but exceeds capacity, and next is set so the
+    ///     caller can skip it; DUMP_READ_END at the end of the store.
+    DumpReadResult Read(uint64_t offset, DumpRecordHeader* header, void* data, size_t capacity,
+        uint64_t* next) const;
+
+    /// The committed store file size in bytes
+    uint64_t Size() const { return m_size; }
+
+    /// Total records and duplicate records appended since Open()
+    uint64_t RecordCount() const { return m_records; }
+    uint64_t DuplicateCount() const { return m_duplicates; }
+
+private:
+    DumpStore(const DumpStore&) = delete;
+    DumpStore& operator=(const DumpStore&) = delete;
+
+    // Insert a stack hash into the index. Returns false if already present.
+    bool IndexInsert(uint64_t stackHash);
+
+    // Returns true if a stack hash is within the index
+    bool IndexContains(uint64_t stackHash) const;
+
+    // Drop the queued records of a failed commit
+    void DropQueued();
+
+    int m_fd;
+    uint64_t m_size;
+    uint64_t m_sequence;
+    uint64_t m_records;
+    uint64_t m_duplicates;
+
+    uint64_t* m_index;
+    uint32_t m_indexUsed;
+
+    int m_queued;
+    DumpRecordHeader m_headers[DUMP_STORE_BATCH];
+    struct iovec m_iov[DUMP_STORE_BATCH * 2];
+};
+
+#endif
+#endif
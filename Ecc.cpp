@@ -0,0 +1,154 @@
+#include "Ecc.h"
+#include <cstring>
+
+// Hsiao SECDED code. Each data bit is assigned an odd weight 8-bit column 
+// within the parity check matrix (56 columns of weight 3, then 8 of weight 5).
+// A non-zero syndrome of odd weight identifies a single bit error; an even 
+// weight syndrome indicates a multiple bit error.
+
+static constexpr int PopCount(uint32_t value)
+{
+    int count = 0;
+    for (; value != 0; value &= value - 1)
+        count++;
+    return count;
+}
+
+// Lookup tables generated at compile time
+struct EccTables
+{
+    // Check bits contributed by each byte value at each byte position
+    uint8_t Encode[8][256];
+
+    // Bit in error for each syndrome: 0-63 data bit, 64-71 check bit, -1 none
+    int8_t SyndromeBit[256];
+
+    constexpr EccTables() : Encode(), SyndromeBit()
+    {
+        uint8_t columns[64] = {};
+        int count = 0;
+        for (int weight = 3; weight <= 5; weight += 2)
+        {
+            for (uint32_t value = 0; value < 256 && count < 64; value++)
+            {
+                if (PopCount(value) == weight)
+                    columns[count++] = (uint8_t)value;
+            }
+        }
+
+        for (int pos = 0; pos < 8; pos++)
+        {
+            for (uint32_t value = 0; value < 256; value++)
+            {
+                uint8_t bits = 0;
+                for (int bit = 0; bit < 8; bit++)
+                {
+                    if (value & (1u << bit))
+                        bits ^= columns[pos * 8 + bit];
+                }
+                Encode[pos][value] = bits;
+            }
+        }
+
+        for (int s = 0; s < 256; s++)
+            SyndromeBit[s] = -1;
+        for (int bit = 0; bit < 64; bit++)
+            SyndromeBit[columns[bit]] = (int8_t)bit;
+        for (int bit = 0; bit < 8; bit++)
+            SyndromeBit[1 << bit] = (int8_t)(64 + bit);
+    }
+};
+
+static constexpr EccTables _tables;
+
+// Compute the check byte of a 64-bit word
+static inline uint8_t CheckByte(uint64_t word)
+{
+    return _tables.Encode[0][word & 0xFF] ^
+        _tables.Encode[1][(word >> 8) & 0xFF] ^
+        _tables.Encode[2][(word >> 16) & 0xFF] ^
+        _tables.Encode[3][(word >> 24) & 0xFF] ^
+        _tables.Encode[4][(word >> 32) & 0xFF] ^
+        _tables.Encode[5][(word >> 40) & 0xFF] ^
+        _tables.Encode[6][(word >> 48) & 0xFF] ^
+        _tables.Encode[7][word >> 56];
+}
+
+// Read data word idx; a partial last word is zero padded
+static inline uint64_t LoadWord(const uint8_t* data, size_t length, size_t idx)
+{
+    uint64_t word = 0;
+    size_t offset = idx * 8;
+    memcpy(&word, data + offset, length - offset < 8 ? length - offset : 8);
+    return word;
+}
+
+static inline void StoreWord(uint8_t* data, size_t length, size_t idx, uint64_t word)
+{
+    size_t offset = idx * 8;
+    memcpy(data + offset, &word, length - offset < 8 ? length - offset : 8);
+}
+
+void EccEncode(const void* data, size_t length, uint8_t* check)
+{
+    EccUpdate(data, length, check, 0, length);
+}
+
+void EccUpdate(const void* data, size_t length, uint8_t* check, size_t offset, size_t count)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    if (offset >= length || count == 0)
+        return;
+    if (count > length - offset)
+        count = length - offset;
+
+    size_t last = (offset + count - 1) / 8;
+    for (size_t idx = offset / 8; idx <= last; idx++)
+        check[idx] = CheckByte(LoadWord(bytes, length, idx));
+}
+
+int EccRepairWord(uint64_t* word, uint8_t* check)
+{
+    uint8_t syndrome = CheckByte(*word) ^ *check;
+    if (syndrome == 0)
+        return 0;
+
+    // An even weight syndrome is a multiple bit error
+    int bit = _tables.SyndromeBit[syndrome];
+    if (bit < 0)
+        return -1;
+
+    if (bit < 64)
+        *word ^= 1ull << bit;
+    else
+        *check ^= (uint8_t)(1u << (bit - 64));
+    return 1;
+}
+
+EccResult EccRepair(void* data, size_t length, uint8_t* check)
+{
+    uint8_t* bytes = (uint8_t*)data;
+    EccResult result = { 0, 0 };
+
+    size_t words = ECC_CHECK_SIZE(length);
+    for (size_t idx = 0; idx < words; idx++)
+    {
+        uint64_t word = LoadWord(bytes, length, idx);
+
+        // Fast path; most words have no error
+        if (CheckByte(word) == check[idx])
+            continue;
+
+        int status = EccRepairWord(&word, &check[idx]);
+        if (status > 0)
+        {
+            StoreWord(bytes, length, idx, word);
+            result.Corrected++;
+        }
+        else if (status < 0)
+        {
+            result.Uncorrectable++;
+        }
+    }
+    return result;
+}
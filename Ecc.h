@@ -0,0 +1,48 @@
+#ifndef _ECC_H
+#define _ECC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Number of check bytes required to protect a data block. One check byte 
+// protects each 64-bit data word.
+#define ECC_CHECK_SIZE(length)  (((length) + 7) / 8)
+
+/// Result of an ECC repair
+struct EccResult
+{
+    uint32_t Corrected;         // Number of single bit errors corrected
+    uint32_t Uncorrectable;     // Number of words with multiple bit errors
+};
+
+/// Compute the Hamming SECDED (72,64) check bytes for a data block. 
+/// @param[in] data - the data to protect
+/// @param[in] length - the data length in bytes. A partial last word is 
+///     treated as zero padded.
+/// @param[out] check - ECC_CHECK_SIZE(length) check bytes
+void EccEncode(const void* data, size_t length, uint8_t* check);
+
+/// Update the check bytes after modifying part of a data block.
+/// @param[in] data - the protected data block
+/// @param[in] length - the data block length in bytes
+/// @param[in,out] check - the data block check bytes
+/// @param[in] offset - the first modified byte
+/// @param[in] count - the number of modified bytes
+void EccUpdate(const void* data, size_t length, uint8_t* check, size_t offset, size_t count);
+
+/// Check a data block and correct any single bit error within each 64-bit 
+/// word (or its check byte). Multiple bit errors within a word are detected
+/// but not corrected.
+/// @param[in,out] data - the protected data block
+/// @param[in] length - the data block length in bytes
+/// @param[in,out] check - the data block check bytes
+/// @return The number of corrected and uncorrectable words.
+EccResult EccRepair(void* data, size_t length, uint8_t* check);
+
+/// Check and correct a single 64-bit word.
+/// @param[in,out] word - the data word
+/// @param[in,out] check - the word check byte
+/// @return 0 if no error, 1 if corrected, -1 if uncorrectable.
+int EccRepairWord(uint64_t* word, uint8_t* check);
+
+#endif 
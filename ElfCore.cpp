@@ -0,0 +1,316 @@
+#include "ElfCore.h"
+
+#ifdef __linux__
+
+#include <cstring>
+#include <elf.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/procfs.h>
+
+#if defined(__x86_64__)
+#define ELF_CORE_MACHINE    EM_X86_64
+
+// user_regs_struct indices within elf_prstatus::pr_reg
+#define GREG_RIP            16
+#define GREG_CS             17
+#define GREG_EFLAGS         18
+#define GREG_SS             20
+#elif defined(__aarch64__)
+#define ELF_CORE_MACHINE    EM_AARCH64
+#endif
+
+#define NOTE_NAME           "CORE"
+#define NOTE_ALIGN(size)    (((size) + 3) & ~3u)
+
+// Thread id of the faulting thread. Captured OS task stacks follow.
+#define THREAD_ID_FAULT     1
+
+#ifdef ELF_CORE_MACHINE
+// Get the faulting thread registers in DWARF register numbering. Signal
+// registers are preferred; otherwise the stack slice unwind registers.
+static bool GetRegisters(const CoreDumpData* coreDumpData, uint64_t* regs, uint64_t* flags)
+{
+    memset(regs, 0, sizeof(uint64_t) * UNWIND_REGISTER_CNT);
+    *flags = 0;
+
+#if defined(USE_SIGNAL_REGISTERS) && defined(__x86_64__)
+    if (coreDumpData->SignalNumber != 0)
+    {
+        const CoreDumpX86_64Registers* r = &coreDumpData->Registers;
+        const uint64_t values[UNWIND_REGISTER_CNT] = { r->RAX, r->RDX, r->RCX, r->RBX,
+            r->RSI, r->RDI, r->RBP, r->RSP, r->R8, r->R9, r->R10, r->R11, r->R12,
+            r->R13, r->R14, r->R15, r->RIP };
+        memcpy(regs, values, sizeof(values));
+        *flags = r->EFLAGS;
+        return true;
+    }
+#elif defined(USE_SIGNAL_REGISTERS)
+    if (coreDumpData->SignalNumber != 0)
+    {
+        const CoreDumpAArch64Registers* r = &coreDumpData->Registers;
+        memcpy(regs, r->X, sizeof(r->X));
+        regs[UNWIND_REGISTER_SP] = r->SP;
+        regs[UNWIND_REGISTER_PC] = r->PC;
+        *flags = r->PSTATE;
+        return true;
+    }
+#endif
+
+#ifdef USE_STACK_SLICE
+    if (coreDumpData->StackSliceRegisterMask != 0)
+    {
+        for (int r = 0; r < UNWIND_REGISTER_CNT; r++)
+            regs[r] = (uint64_t)coreDumpData->StackSliceRegisters[r];
+        return true;
+    }
+#else
+    (void)coreDumpData;
+#endif
+    return false;
+}
+#endif
+
+ElfCoreWriter::ElfCoreWriter() :
+    m_used(0),
+    m_overflow(false),
+    m_loadCnt(0)
+{
+}
+
+// Reserve zeroed metadata space. Returns NULL if the metadata is full.
+void* ElfCoreWriter::Reserve(uint32_t size)
+{
+    if (m_used + size > sizeof(m_meta))
+    {
+        m_overflow = true;
+        return NULL;
+    }
+    void* p = &m_meta[m_used];
+    memset(p, 0, size);
+    m_used += size;
+    return p;
+}
+
+void ElfCoreWriter::AddLoad(uint64_t address, const void* data, uint32_t length)
+{
+    if (m_loadCnt >= ELF_CORE_MAX_LOADS || length == 0)
+        return;
+    m_loads[m_loadCnt].Address = address;
+    m_loads[m_loadCnt].Data = (const uint8_t*)data;
+    m_loads[m_loadCnt].Length = length;
+    m_loadCnt++;
+}
+
+// Append an NT_PRSTATUS note. The faulting thread (stackPointer 0) gets the
+// captured registers; an OS task gets only its saved stack pointer.
+void ElfCoreWriter::PutPrStatus(const CoreDumpData* coreDumpData, uint32_t threadId, uint64_t stackPointer)
+{
+#ifdef ELF_CORE_MACHINE
+    Elf64_Nhdr* note = (Elf64_Nhdr*)Reserve(sizeof(Elf64_Nhdr));
+    char* name = (char*)Reserve(NOTE_ALIGN(sizeof(NOTE_NAME)));
+    struct elf_prstatus* status = (struct elf_prstatus*)Reserve(NOTE_ALIGN(sizeof(struct elf_prstatus)));
+    if (note == NULL || name == NULL || status == NULL)
+        return;
+
+    note->n_namesz = sizeof(NOTE_NAME);
+    note->n_descsz = sizeof(struct elf_prstatus);
+    note->n_type = NT_PRSTATUS;
+    memcpy(name, NOTE_NAME, sizeof(NOTE_NAME));
+
+    status->pr_pid = threadId;
+    status->pr_ppid = 0;
+    status->pr_pgrp = THREAD_ID_FAULT;
+    status->pr_sid = THREAD_ID_FAULT;
+
+    uint64_t regs[UNWIND_REGISTER_CNT];
+    uint64_t flags = 0;
+    if (stackPointer != 0)
+    {
+        memset(regs, 0, sizeof(regs));
+        regs[UNWIND_REGISTER_SP] = stackPointer;
+    }
+    else
+    {
+        GetRegisters(coreDumpData, regs, &flags);
+#ifdef USE_LINUX_SIGNALS
+        status->pr_info.si_signo = coreDumpData->SignalNumber;
+        status->pr_info.si_code = coreDumpData->SignalCode;
+        status->pr_cursig = (short)coreDumpData->SignalNumber;
+#endif
+    }
+
+#if defined(__x86_64__)
+    // user_regs_struct index of each DWARF register RAX RDX RCX RBX RSI RDI
+    // RBP RSP R8-R15 RIP
+    static const int order[UNWIND_REGISTER_CNT] = { 10, 12, 11, 5, 13, 14, 4, 19,
+        9, 8, 7, 6, 3, 2, 1, 0, GREG_RIP };
+    for (int r = 0; r < UNWIND_REGISTER_CNT; r++)
+        status->pr_reg[order[r]] = regs[r];
+    status->pr_reg[GREG_EFLAGS] = flags;
+    status->pr_reg[GREG_CS] = 0x33;     // Linux user code segment
+    status->pr_reg[GREG_SS] = 0x2b;     // Linux user data segment
+#elif defined(__aarch64__)
+    // X0-X30, SP, PC, PSTATE
+    for (int r = 0; r < UNWIND_REGISTER_CNT; r++)
+        status->pr_reg[r] = regs[r];
+    status->pr_reg[UNWIND_REGISTER_CNT] = flags;
+#endif
+#else
+    (void)coreDumpData;
+    (void)threadId;
+    (void)stackPointer;
+#endif
+}
+
+bool ElfCoreWriter::Write(int fd, const CoreDumpData* coreDumpData)
+{
+#ifndef ELF_CORE_MACHINE
+    (void)fd;
+    (void)coreDumpData;
+    return false;
+#else
+    m_used = 0;
+    m_overflow = false;
+    m_loadCnt = 0;
+
+    // Collect the captured memory and the OS task stack pointers
+    uint64_t taskStacks[OS_TASKCNT];
+    int taskCnt = 0;
+#ifdef USE_STACK_SLICE
+    if (coreDumpData->StackSliceLength <= STACK_SLICE_SIZE)
+        AddLoad((uint64_t)coreDumpData->StackSliceAddress, coreDumpData->StackSlice,
+            coreDumpData->StackSliceLength);
+#endif
+#ifdef USE_MEMORY_REGIONS
+    uint32_t regionCnt = coreDumpData->RegionCount;
+    if (regionCnt > MAX_STORED_REGIONS)
+        regionCnt = MAX_STORED_REGIONS;
+    for (uint32_t r = 0; r < regionCnt; r++)
+    {
+        const CoreDumpRegion* region = &coreDumpData->Regions[r];
+        if (region->Offset > MEMORY_REGION_BLOB_SIZE ||
+            region->Length > MEMORY_REGION_BLOB_SIZE - region->Offset)
+            continue;
+        AddLoad((uint64_t)region->Address, &coreDumpData->RegionBlob[region->Offset], region->Length);
+        if (strncmp(region->Name, "task", 4) == 0 && taskCnt < OS_TASKCNT)
+            taskStacks[taskCnt++] = (uint64_t)region->Address;
+    }
+#endif
+
+    Elf64_Ehdr* ehdr = (Elf64_Ehdr*)Reserve(sizeof(Elf64_Ehdr));
+    Elf64_Phdr* phdrs = (Elf64_Phdr*)Reserve(sizeof(Elf64_Phdr) * (1 + m_loadCnt));
+    if (ehdr == NULL || phdrs == NULL)
+        return false;
+
+    memcpy(ehdr->e_ident, ELFMAG, SELFMAG);
+    ehdr->e_ident[EI_CLASS] = ELFCLASS64;
+    ehdr->e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr->e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr->e_ident[EI_OSABI] = ELFOSABI_NONE;
+    ehdr->e_type = ET_CORE;
+    ehdr->e_machine = ELF_CORE_MACHINE;
+    ehdr->e_version = EV_CURRENT;
+    ehdr->e_phoff = sizeof(Elf64_Ehdr);
+    ehdr->e_ehsize = sizeof(Elf64_Ehdr);
+    ehdr->e_phentsize = sizeof(Elf64_Phdr);
+    ehdr->e_phnum = (Elf64_Half)(1 + m_loadCnt);
+
+    // One NT_PRSTATUS note per thread; the faulting thread first
+    uint32_t notesOffset = m_used;
+    PutPrStatus(coreDumpData, THREAD_ID_FAULT, 0);
+    for (int t = 0; t < taskCnt; t++)
+        PutPrStatus(coreDumpData, THREAD_ID_FAULT + 1 + t, taskStacks[t]);
+    if (m_overflow)
+        return false;
+
+    phdrs[0].p_type = PT_NOTE;
+    phdrs[0].p_offset = notesOffset;
+    phdrs[0].p_filesz = m_used - notesOffset;
+    phdrs[0].p_align = 4;
+
+    // Captured memory follows the metadata
+    uint64_t offset = m_used;
+    for (int l = 0; l < m_loadCnt; l++)
+    {
+        Elf64_Phdr* phdr = &phdrs[1 + l];
+        phdr->p_type = PT_LOAD;
+        phdr->p_flags = PF_R | PF_W;
+        phdr->p_offset = offset;
+        phdr->p_vaddr = m_loads[l].Address;
+        phdr->p_filesz = m_loads[l].Length;
+        phdr->p_memsz = m_loads[l].Length;
+        phdr->p_align = 1;
+        offset += m_loads[l].Length;
+    }
+
+    return Flush(fd);
+#endif
+}
+
+// Write the metadata and load segments front to back. Each pwritev() call
+// writes at most ELF_CORE_MAX_IOV pieces and ELF_CORE_WRITE_LIMIT bytes.
+bool ElfCoreWriter::Flush(int fd)
+{
+    int piece = 0;          // 0 is the metadata, then each load segment
+    uint32_t pieceOffset = 0;
+    uint64_t fileOffset = 0;
+    const int pieceCnt = 1 + m_loadCnt;
+
+    while (piece < pieceCnt)
+    {
+        int iovCnt = 0;
+        size_t total = 0;
+        int p = piece;
+        uint32_t offset = pieceOffset;
+        while (p < pieceCnt && iovCnt < ELF_CORE_MAX_IOV && total < ELF_CORE_WRITE_LIMIT)
+        {
+            const uint8_t* data = p == 0 ? m_meta : m_loads[p - 1].Data;
+            uint32_t length = p == 0 ? m_used : m_loads[p - 1].Length;
+            size_t count = length - offset;
+            if (count > ELF_CORE_WRITE_LIMIT - total)
+                count = ELF_CORE_WRITE_LIMIT - total;
+
+            m_iov[iovCnt].iov_base = (void*)(data + offset);
+            m_iov[iovCnt].iov_len = count;
+            iovCnt++;
+            total += count;
+            offset += count;
+            if (offset == length)
+            {
+                p++;
+                offset = 0;
+            }
+        }
+
+        ssize_t written = pwritev(fd, m_iov, iovCnt, fileOffset);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        fileOffset += written;
+
+        // Advance by the bytes written; a short write resumes mid piece
+        size_t remaining = written;
+        while (remaining > 0)
+        {
+            uint32_t length = piece == 0 ? m_used : m_loads[piece - 1].Length;
+            size_t count = length - pieceOffset;
+            if (remaining < count)
+            {
+                pieceOffset += remaining;
+                break;
+            }
+            remaining -= count;
+            piece++;
+            pieceOffset = 0;
+        }
+    }
+
+    // Remove any previous contents beyond the new core
+    return ftruncate(fd, fileOffset) == 0;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef _ELF_CORE_H
+#define _ELF_CORE_H
+
+// Minimal ELF core file writer. Converts a CoreDumpData structure into an
+// ET_CORE file holding a PT_NOTE segment with an NT_PRSTATUS note for each
+// captured thread and one PT_LOAD segment per captured memory window (the
+// stack slice and the memory regions). Load the result with:
+//
+//   gdb <executable> <core>
+//
+// Only the captured memory is written, so the core is typically tens of
+// kilobytes. Memory is written directly from the CoreDumpData structure
+// using pwritev(). Supported on x86-64 and AArch64.
+
+#ifdef __linux__
+
+#include "CoreDump.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+// Maximum bytes written by a single pwritev() call
+#define ELF_CORE_WRITE_LIMIT    (64 * 1024)
+
+#define ELF_CORE_MAX_IOV        64
+
+#define ELF_CORE_MAX_THREADS    (1 + OS_TASKCNT)
+
+// Stack slice plus memory regions
+#ifdef USE_MEMORY_REGIONS
+#define ELF_CORE_MAX_LOADS      (1 + MAX_STORED_REGIONS)
+#else
+#define ELF_CORE_MAX_LOADS      1
+#endif
+
+// ELF header, program headers and notes
+#define ELF_CORE_META_SIZE      (64 + (1 + ELF_CORE_MAX_LOADS) * 56 + ELF_CORE_MAX_THREADS * 512)
+
+class ElfCoreWriter
+{
+public:
+    ElfCoreWriter();
+
+    /// Write an ELF core file. No memory is allocated.
+    /// @param[in] fd - the output file, written from offset 0
+    /// @param[in] coreDumpData - the core dump to convert
+    /// @return True if successful. False if the architecture is not supported.
+    bool Write(int fd, const CoreDumpData* coreDumpData);
+
+private:
+    ElfCoreWriter(const ElfCoreWriter&) = delete;
+    ElfCoreWriter& operator=(const ElfCoreWriter&) = delete;
+
+    /// A captured memory window written as a PT_LOAD segment
+    struct LoadSegment
+    {
+        uint64_t Address;
+        const uint8_t* Data;
+        uint32_t Length;
+    };
+
+    void* Reserve(uint32_t size);
+    void AddLoad(uint64_t address, const void* data, uint32_t length);
+    void PutPrStatus(const CoreDumpData* coreDumpData, uint32_t threadId, uint64_t stackPointer);
+    bool Flush(int fd);
+
+    uint8_t m_meta[ELF_CORE_META_SIZE];
+    uint32_t m_used;
+    bool m_overflow;
+
+    LoadSegment m_loads[ELF_CORE_MAX_LOADS];
+    int m_loadCnt;
+
+    struct iovec m_iov[ELF_CORE_MAX_IOV];
+};
+
+#endif
+#endif
@@ -1,6 +1,11 @@
 #include "Fault.h"
 #include "CoreDump.h"
 #include <stdio.h>
+#include <string.h>
+
+#ifdef USE_LINUX_SIGNALS
+#include <atomic>
+#endif
 
 void FaultHandler(const char* file, unsigned short line)
 {
@@ -17,6 +22,22 @@ void FaultHandler(const char* file, unsigned short line)
 	//while (true);
 }
 
+#ifdef USE_ASSERT_SITES
+void FaultSiteHandler(AssertSite* site)
+{
+	site->Failures.fetch_add(1, std::memory_order_relaxed);
+
+	// Store software assertion core dump data with the site id
+	CoreDumpStoreAssert(site, 0);
+
+	printf("Fault at assert site %u (file %s line %u).\n", AssertSiteId(site), site->File, site->Line);
+	printf("The _coreDumpData structure has crash results.\n");
+	printf("Use a debugger to view the structure or store somewhere.\n");
+
+	// TODO: Reboot CPU here! After reboot, the core dump data is used.
+}
+#endif
+
 void HardFaultHandler(void)
 {
 	// TODO: Called if a hardware exception is generated. Platform 
@@ -41,4 +62,128 @@ void HardFaultHandler(void)
 
 	// If you hit this line, it means a hardware exception occurred.
 	while (true);
-}
\ No newline at end of file
+}
+
+#ifdef USE_LINUX_SIGNALS
+// The fatal signals connected to SignalFaultHandler()
+static const int _faultSignals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL };
+#define FAULT_SIGNAL_CNT (sizeof(_faultSignals) / sizeof(_faultSignals[0]))
+
+// Signal actions installed before SignalFaultInstall(). Chained to after
+// the core dump is stored.
+static struct sigaction _previousActions[FAULT_SIGNAL_CNT];
+
+// Preallocated alternate signal stacks. A thread that overflows its stack 
+// has no stack remaining to run the signal handler.
+alignas(16) static char _signalStacks[SIGNAL_STACK_CNT][SIGNAL_STACK_SIZE];
+static std::atomic_flag _signalStackUsed[SIGNAL_STACK_CNT] = {};
+static thread_local int _signalStackIdx = -1;
+
+void SignalFaultHandler(int signalNumber, siginfo_t* signalInfo, void* userContext)
+{
+	// Store fatal signal core dump data, including the faulting registers,
+	// signal code and faulting address
+	CoreDumpStoreSignal(signalNumber, signalInfo, userContext, __FILE__, __LINE__);
+
+	// Chain to the previously installed handler, if any
+	for (unsigned int s = 0; s < FAULT_SIGNAL_CNT; s++)
+	{
+		if (_faultSignals[s] != signalNumber)
+			continue;
+
+		const struct sigaction* previous = &_previousActions[s];
+		if (previous->sa_flags & SA_SIGINFO)
+		{
+			if (previous->sa_sigaction != NULL)
+				previous->sa_sigaction(signalNumber, signalInfo, userContext);
+		}
+		else if (previous->sa_handler != SIG_DFL && previous->sa_handler != SIG_IGN)
+		{
+			previous->sa_handler(signalNumber);
+		}
+	}
+
+	// Restore the default action to terminate and write the system core file
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = SIG_DFL;
+	sigemptyset(&action.sa_mask);
+	sigaction(signalNumber, &action, NULL);
+
+	// A fault re-executes the faulting instruction upon return and the default 
+	// action is taken. A signal sent by kill() or raise() must be re-raised; it 
+	// remains blocked until this handler returns.
+	if (signalInfo == NULL || signalInfo->si_code <= 0)
+		raise(signalNumber);
+}
+
+int SignalFaultThreadInit(void)
+{
+	if (_signalStackIdx >= 0)
+		return 1;
+
+	for (int idx = 0; idx < SIGNAL_STACK_CNT; idx++)
+	{
+		if (_signalStackUsed[idx].test_and_set())
+			continue;
+
+		stack_t stack;
+		stack.ss_sp = _signalStacks[idx];
+		stack.ss_size = SIGNAL_STACK_SIZE;
+		stack.ss_flags = 0;
+		if (sigaltstack(&stack, NULL) != 0)
+		{
+			_signalStackUsed[idx].clear();
+			return 0;
+		}
+
+		_signalStackIdx = idx;
+		return 1;
+	}
+
+	// All alternate signal stacks in use. Increase SIGNAL_STACK_CNT.
+	return 0;
+}
+
+void SignalFaultThreadExit(void)
+{
+	if (_signalStackIdx < 0)
+		return;
+
+	stack_t stack;
+	memset(&stack, 0, sizeof(stack));
+	stack.ss_flags = SS_DISABLE;
+	sigaltstack(&stack, NULL);
+
+	_signalStackUsed[_signalStackIdx].clear();
+	_signalStackIdx = -1;
+}
+
+void SignalFaultInstall(void)
+{
+	CoreDumpSignalInit();
+	SignalFaultThreadInit();
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = SignalFaultHandler;
+	action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+	sigemptyset(&action.sa_mask);
+
+	// Block the other fatal signals while handling one
+	for (unsigned int s = 0; s < FAULT_SIGNAL_CNT; s++)
+		sigaddset(&action.sa_mask, _faultSignals[s]);
+
+	for (unsigned int s = 0; s < FAULT_SIGNAL_CNT; s++)
+	{
+		struct sigaction previous;
+		if (sigaction(_faultSignals[s], &action, &previous) != 0)
+			continue;
+
+		// Don't chain to ourselves if installed twice
+		if ((previous.sa_flags & SA_SIGINFO) && previous.sa_sigaction == SignalFaultHandler)
+			continue;
+		_previousActions[s] = previous;
+	}
+}
+#endif
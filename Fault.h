@@ -1,15 +1,41 @@
 #ifndef _FAULT_H
 #define _FAULT_H
 
+#include "Options.h"
+
+#if defined(USE_ASSERT_SITES) && defined(__cplusplus)
+#include "AssertSite.h"
+#endif
+
+#ifdef USE_LINUX_SIGNALS
+#include <signal.h>
+
+// Size of each alternate signal stack. A stack overflow fault runs the 
+// signal handler on the alternate stack.
+#define SIGNAL_STACK_SIZE   (64 * 1024)
+
+// Number of preallocated alternate signal stacks; one per running thread
+#define SIGNAL_STACK_CNT    16
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#if defined(USE_ASSERT_SITES) && defined(__cplusplus)
+// Each site registers a static descriptor; see AssertSite.h
+#define ASSERT() \
+	do {ASSERT_SITE_DEFINE(_assertSite); FaultSiteHandler(&_assertSite);} while (0)
+
+#define ASSERT_TRUE(condition) \
+	do {if (!(condition)) {ASSERT_SITE_DEFINE(_assertSite); FaultSiteHandler(&_assertSite);}} while (0)
+#else
 #define ASSERT() \
 	FaultHandler(__FILE__, (unsigned short) __LINE__)
 
 #define ASSERT_TRUE(condition) \
 	do {if (!(condition)) FaultHandler(__FILE__, (unsigned short) __LINE__);} while (0)
+#endif
 
 	/// Handles all software assertions in the system.
 	/// @param[in] file - the file name that the software assertion occurred on
@@ -19,8 +45,54 @@ extern "C" {
 	/// Handles all hardware exception faults.
 	void HardFaultHandler(void);
 
+#ifdef USE_LINUX_SIGNALS
+	/// Handles fatal signals on Linux. The HardFaultHandler() equivalent.
+	/// @param[in] signalNumber - the signal number
+	/// @param[in] signalInfo - the signal information
+	/// @param[in] userContext - the ucontext_t registers at the time of the fault
+	void SignalFaultHandler(int signalNumber, siginfo_t* signalInfo, void* userContext);
+
+	/// Install SignalFaultHandler() for SIGSEGV, SIGBUS, SIGFPE and SIGILL. 
+	/// Previously installed handlers are called after the core dump is stored.
+	/// Also assigns an alternate signal stack to the calling thread.
+	void SignalFaultInstall(void);
+
+	/// Assign an alternate signal stack from the preallocated pool to the 
+	/// calling thread. Call at the start of each thread, or declare a 
+	/// SignalFaultThread first within the thread function. Without one, a 
+	/// stack overflow on the thread cannot run the handler and no core dump
+	/// is stored. The library's own threads declare a SignalFaultThread.
+	/// @return Returns 1 if assigned, 0 if the pool is exhausted.
+	int SignalFaultThreadInit(void);
+
+	/// Return the calling thread's alternate signal stack to the pool. Call 
+	/// before each thread exits.
+	void SignalFaultThreadExit(void);
+#endif
+
 #ifdef __cplusplus
 }
+
+#ifdef USE_ASSERT_SITES
+/// Handles a failed ASSERT() or ASSERT_TRUE() site. Counts the failure and
+/// stores the core dump with the site id.
+/// @param[in] site - the assertion site
+void FaultSiteHandler(AssertSite* site);
+#endif
+
+#ifdef USE_LINUX_SIGNALS
+/// Assigns an alternate signal stack to the calling thread for the lifetime
+/// of the object. Declare first within each thread function.
+class SignalFaultThread
+{
+public:
+	SignalFaultThread() { SignalFaultThreadInit(); }
+	~SignalFaultThread() { SignalFaultThreadExit(); }
+};
+#endif
+
+// Non-fatal ASSERT_SOFT()
+#include "SoftAssert.h"
 #endif
 
 #endif 
@@ -0,0 +1,535 @@
+#include "Minidump.h"
+
+#ifdef __linux__
+
+#include <cstring>
+#include <cstdio>
+#include <errno.h>
+#include <unistd.h>
+
+#define MD_SIGNATURE                0x504d444d      // "MDMP"
+#define MD_VERSION                  0xa793
+
+// Stream types
+#define MD_THREAD_LIST_STREAM       3
+#define MD_MODULE_LIST_STREAM       4
+#define MD_MEMORY_LIST_STREAM       5
+#define MD_EXCEPTION_STREAM         6
+#define MD_SYSTEM_INFO_STREAM       7
+
+#define MD_OS_LINUX                 0x8201
+
+// Exception code of a core dump stored without a fatal signal
+#define MD_EXCEPTION_DUMP_REQUESTED 0xFFFFFFFF
+
+#define MD_THREAD_ID_FAULT          1
+
+// CodeView record holding an ELF build-id ("BpEL")
+#define MD_CVINFOELF_SIGNATURE      0x4270454c
+
+#define MD_MODULE_PAGE_SIZE         4096
+
+#if defined(__x86_64__)
+#define MD_CPU_ARCHITECTURE         9               // AMD64
+#define MD_CONTEXT_FLAGS            0x00100003      // AMD64 control and integer registers
+#define MD_CONTEXT_SIZE             1232
+#elif defined(__aarch64__)
+#define MD_CPU_ARCHITECTURE         12              // ARM64
+#define MD_CONTEXT_FLAGS            0x00400003      // ARM64 control and integer registers
+#define MD_CONTEXT_SIZE             912
+#elif defined(__i386__)
+#define MD_CPU_ARCHITECTURE         0               // X86
+#define MD_CONTEXT_SIZE             0
+#else
+#define MD_CPU_ARCHITECTURE         5               // ARM
+#define MD_CONTEXT_SIZE             0
+#endif
+
+// Get the faulting thread registers in DWARF register numbering. Signal
+// registers are preferred; otherwise the stack slice unwind registers.
+static bool GetRegisters(const CoreDumpData* coreDumpData, uint64_t* regs, uint64_t* flags)
+{
+    memset(regs, 0, sizeof(uint64_t) * UNWIND_REGISTER_CNT);
+    *flags = 0;
+
+#if defined(USE_SIGNAL_REGISTERS) && defined(__x86_64__)
+    if (coreDumpData->SignalNumber != 0)
+    {
+        const CoreDumpX86_64Registers* r = &coreDumpData->Registers;
+        const uint64_t values[UNWIND_REGISTER_CNT] = { r->RAX, r->RDX, r->RCX, r->RBX,
+            r->RSI, r->RDI, r->RBP, r->RSP, r->R8, r->R9, r->R10, r->R11, r->R12,
+            r->R13, r->R14, r->R15, r->RIP };
+        memcpy(regs, values, sizeof(values));
+        *flags = r->EFLAGS;
+        return true;
+    }
+#elif defined(USE_SIGNAL_REGISTERS)
+    if (coreDumpData->SignalNumber != 0)
+    {
+        const CoreDumpAArch64Registers* r = &coreDumpData->Registers;
+        memcpy(regs, r->X, sizeof(r->X));
+        regs[UNWIND_REGISTER_SP] = r->SP;
+        regs[UNWIND_REGISTER_PC] = r->PC;
+        *flags = r->PSTATE;
+        return true;
+    }
+#endif
+
+#ifdef USE_STACK_SLICE
+    if (coreDumpData->StackSliceRegisterMask != 0)
+    {
+        for (int r = 0; r < UNWIND_REGISTER_CNT; r++)
+            regs[r] = (uint64_t)coreDumpData->StackSliceRegisters[r];
+        return true;
+    }
+#else
+    (void)coreDumpData;
+#endif
+    return false;
+}
+
+MinidumpWriter::MinidumpWriter()
+{
+    Reset();
+}
+
+void MinidumpWriter::Reset()
+{
+    m_used = 0;
+    m_overflow = false;
+    m_directory = 0;
+    m_streamCnt = 0;
+    m_streamStart = 0;
+    m_memoryCnt = 0;
+    m_rvaPatchCnt = 0;
+}
+
+uint32_t MinidumpWriter::Put32(uint32_t value)
+{
+    uint32_t offset = m_used;
+    if (m_used + 4 > sizeof(m_meta))
+    {
+        m_overflow = true;
+        return offset;
+    }
+    for (int b = 0; b < 4; b++)
+        m_meta[m_used++] = (uint8_t)(value >> (b * 8));
+    return offset;
+}
+
+uint32_t MinidumpWriter::Put16(uint16_t value)
+{
+    uint32_t offset = m_used;
+    if (m_used + 2 > sizeof(m_meta))
+    {
+        m_overflow = true;
+        return offset;
+    }
+    m_meta[m_used++] = (uint8_t)value;
+    m_meta[m_used++] = (uint8_t)(value >> 8);
+    return offset;
+}
+
+uint32_t MinidumpWriter::Put64(uint64_t value)
+{
+    uint32_t offset = Put32((uint32_t)value);
+    Put32((uint32_t)(value >> 32));
+    return offset;
+}
+
+uint32_t MinidumpWriter::PutZero(uint32_t count)
+{
+    uint32_t offset = m_used;
+    if (m_used + count > sizeof(m_meta))
+    {
+        m_overflow = true;
+        return offset;
+    }
+    memset(&m_meta[m_used], 0, count);
+    m_used += count;
+    return offset;
+}
+
+void MinidumpWriter::Align(uint32_t alignment)
+{
+    PutZero((alignment - (m_used % alignment)) % alignment);
+}
+
+void MinidumpWriter::Patch32(uint32_t offset, uint32_t value)
+{
+    if (offset + 4 > m_used)
+        return;
+    for (int b = 0; b < 4; b++)
+        m_meta[offset + b] = (uint8_t)(value >> (b * 8));
+}
+
+void MinidumpWriter::Patch64(uint32_t offset, uint64_t value)
+{
+    Patch32(offset, (uint32_t)value);
+    Patch32(offset + 4, (uint32_t)(value >> 32));
+}
+
+int MinidumpWriter::AddMemory(uint64_t address, const void* data, uint32_t length)
+{
+    if (m_memoryCnt >= MINIDUMP_MAX_MEMORY || length == 0)
+        return -1;
+    MemoryBlock* block = &m_memory[m_memoryCnt];
+    block->Address = address;
+    block->Data = (const uint8_t*)data;
+    block->Length = length;
+    block->Rva = 0;
+    return m_memoryCnt++;
+}
+
+// MINIDUMP_MEMORY_DESCRIPTOR. The RVA is patched once the metadata is complete.
+void MinidumpWriter::PutMemoryDescriptor(int block)
+{
+    if (block < 0)
+    {
+        PutZero(16);
+        return;
+    }
+    Put64(m_memory[block].Address);
+    Put32(m_memory[block].Length);
+    m_rvaPatch[m_rvaPatchCnt] = Put32(0);
+    m_rvaBlock[m_rvaPatchCnt++] = block;
+}
+
+void MinidumpWriter::BeginStream(uint32_t type)
+{
+    Align(8);
+    m_streamStart = m_used;
+    Patch32(m_directory + m_streamCnt * 12, type);
+}
+
+void MinidumpWriter::EndStream()
+{
+    Patch32(m_directory + m_streamCnt * 12 + 4, m_used - m_streamStart);
+    Patch32(m_directory + m_streamCnt * 12 + 8, m_streamStart);
+    m_streamCnt++;
+}
+
+// Write the faulting thread CONTEXT. Returns its offset, or 0 if none.
+uint32_t MinidumpWriter::PutContext(const CoreDumpData* coreDumpData)
+{
+    uint64_t regs[UNWIND_REGISTER_CNT];
+    uint64_t flags;
+    if (MD_CONTEXT_SIZE == 0 || !GetRegisters(coreDumpData, regs, &flags))
+        return 0;
+
+    Align(16);
+    uint32_t start = m_used;
+#if defined(__x86_64__)
+    PutZero(48);                        // P1Home-P6Home
+    Put32(MD_CONTEXT_FLAGS);
+    Put32(0);                           // MxCsr
+    PutZero(12);                        // Segment registers
+    Put32((uint32_t)flags);
+    PutZero(48);                        // Debug registers
+
+    // CONTEXT order: RAX RCX RDX RBX RSP RBP RSI RDI R8-R15 RIP
+    static const int order[] = { 0, 2, 1, 3, 7, 6, 4, 5, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    for (int r : order)
+        Put64(regs[r]);
+    PutZero(512 + 26 * 16 + 6 * 8);     // Floating point, vector and branch registers
+#elif defined(__aarch64__)
+    Put32(MD_CONTEXT_FLAGS);
+    Put32((uint32_t)flags);             // CPSR
+    for (int r = 0; r < 31; r++)
+        Put64(regs[r]);
+    Put64(regs[UNWIND_REGISTER_SP]);
+    Put64(regs[UNWIND_REGISTER_PC]);
+    PutZero(32 * 16 + 8 + 8 * 4 + 8 * 8 + 2 * 4 + 2 * 8);   // Vector and debug registers
+#endif
+    return start;
+}
+
+// Write the MINIDUMP_MODULE_LIST of the modules referenced by the module
+// relative call stack. The module size is not stored; each module spans
+// from its load base to the page holding its highest captured call stack
+// address, a conservative range covering every address the minidump uses.
+void MinidumpWriter::PutModuleList(const CoreDumpData* coreDumpData)
+{
+#ifdef USE_MODULE_RELATIVE_STACK
+    uint32_t moduleCnt = coreDumpData->ModuleCount;
+    if (moduleCnt > MAX_STACK_MODULES)
+        moduleCnt = MAX_STACK_MODULES;
+    if (moduleCnt == 0)
+        return;
+
+    uint32_t sizes[MAX_STACK_MODULES] = {};
+    for (int s = 0; s < CALL_STACK_SIZE; s++)
+    {
+        uint32_t m = coreDumpData->ActiveCallStackModule[s];
+        uint32_t offset = coreDumpData->ActiveCallStackOffset[s];
+        if (m < moduleCnt && offset != 0 && offset >= sizes[m])
+            sizes[m] = (offset / MD_MODULE_PAGE_SIZE + 1) * MD_MODULE_PAGE_SIZE;
+    }
+
+    // MINIDUMP_MODULE entries. The name and CodeView RVAs are patched once
+    // written after the stream.
+    uint32_t nameLocation[MAX_STACK_MODULES];
+    uint32_t cvLocation[MAX_STACK_MODULES];
+    BeginStream(MD_MODULE_LIST_STREAM);
+    Put32(moduleCnt);
+    for (uint32_t m = 0; m < moduleCnt; m++)
+    {
+        const CoreDumpModule* module = &coreDumpData->Modules[m];
+        Put64(module->LoadBase);        // BaseOfImage
+        Put32(sizes[m]);                // SizeOfImage
+        Put32(0);                       // CheckSum
+        Put32(0);                       // TimeDateStamp
+        nameLocation[m] = Put32(0);
+        PutZero(52);                    // VS_FIXEDFILEINFO
+        cvLocation[m] = PutZero(8);
+        PutZero(8);                     // MiscRecord
+        PutZero(16);                    // Reserved0, Reserved1
+    }
+    EndStream();
+
+    for (uint32_t m = 0; m < moduleCnt; m++)
+    {
+        const CoreDumpModule* module = &coreDumpData->Modules[m];
+
+        // Module name MINIDUMP_STRING in UTF-16
+        uint32_t nameLength = (uint32_t)strnlen(module->Name, MODULE_NAME_LEN);
+        Align(4);
+        Patch32(nameLocation[m], m_used);
+        Put32(nameLength * 2);
+        for (uint32_t c = 0; c < nameLength; c++)
+            Put16((uint8_t)module->Name[c]);
+        Put16(0);
+
+        // CodeView record identifying the module by its build-id
+        uint32_t buildIdLength = module->BuildIdLength;
+        if (buildIdLength == 0 || buildIdLength > BUILD_ID_LEN)
+            continue;
+        Align(4);
+        Patch32(cvLocation[m], 4 + buildIdLength);
+        Patch32(cvLocation[m] + 4, m_used);
+        Put32(MD_CVINFOELF_SIGNATURE);
+        uint32_t buildId = PutZero(buildIdLength);
+        if (!m_overflow)
+            memcpy(&m_meta[buildId], module->BuildId, buildIdLength);
+    }
+#else
+    (void)coreDumpData;
+#endif
+}
+
+bool MinidumpWriter::Write(int fd, const CoreDumpData* coreDumpData)
+{
+    Reset();
+
+    // Collect the captured memory. The stack slice is the faulting thread stack.
+    int stackBlock = -1;
+#ifdef USE_STACK_SLICE
+    if (coreDumpData->StackSliceLength <= STACK_SLICE_SIZE)
+        stackBlock = AddMemory((uint64_t)coreDumpData->StackSliceAddress,
+            coreDumpData->StackSlice, coreDumpData->StackSliceLength);
+#endif
+
+    int taskBlocks[OS_TASKCNT];
+    int taskCnt = 0;
+#ifdef USE_MEMORY_REGIONS
+    uint32_t regionCnt = coreDumpData->RegionCount;
+    if (regionCnt > MAX_STORED_REGIONS)
+        regionCnt = MAX_STORED_REGIONS;
+    for (uint32_t r = 0; r < regionCnt; r++)
+    {
+        const CoreDumpRegion* region = &coreDumpData->Regions[r];
+        if (region->Offset > MEMORY_REGION_BLOB_SIZE ||
+            region->Length > MEMORY_REGION_BLOB_SIZE - region->Offset)
+            continue;
+
+        int block = AddMemory((uint64_t)region->Address,
+            &coreDumpData->RegionBlob[region->Offset], region->Length);
+
+        // Use the captured stack top if there is no stack slice; task stack
+        // tops become threads without registers
+        if (strncmp(region->Name, "stack", REGION_NAME_LEN) == 0 && stackBlock < 0)
+            stackBlock = block;
+        else if (strncmp(region->Name, "task", 4) == 0 && taskCnt < OS_TASKCNT)
+            taskBlocks[taskCnt++] = block;
+    }
+#endif
+
+    // MINIDUMP_HEADER
+    Put32(MD_SIGNATURE);
+    Put32(MD_VERSION);
+    uint32_t streamCntOffset = Put32(0);
+    uint32_t directoryRvaOffset = Put32(0);
+    Put32(0);                           // CheckSum
+    Put32(0);                           // TimeDateStamp
+    Put64(0);                           // Flags
+
+    // Stream directory
+    m_directory = PutZero(MINIDUMP_MAX_STREAMS * 12);
+    Patch32(directoryRvaOffset, m_directory);
+
+    // MINIDUMP_SYSTEM_INFO
+    BeginStream(MD_SYSTEM_INFO_STREAM);
+    Put16(MD_CPU_ARCHITECTURE);
+    Put16(0);                           // ProcessorLevel
+    Put16(0);                           // ProcessorRevision
+    Put16(0);                           // NumberOfProcessors, ProductType
+    Put32(0);                           // MajorVersion
+    Put32(0);                           // MinorVersion
+    Put32(0);                           // BuildNumber
+    Put32(MD_OS_LINUX);
+    uint32_t csdOffset = Put32(0);
+    Put32(0);                           // SuiteMask, Reserved2
+    PutZero(24);                        // CPU_INFORMATION
+    EndStream();
+
+    // Empty service pack MINIDUMP_STRING
+    Align(4);
+    Patch32(csdOffset, m_used);
+    Put32(0);
+    Put16(0);
+
+    // MINIDUMP_THREAD_LIST. The faulting thread, then OS task stacks.
+    BeginStream(MD_THREAD_LIST_STREAM);
+    Put32(1 + taskCnt);
+    uint32_t contextLocation = 0;
+    for (int t = 0; t <= taskCnt; t++)
+    {
+        Put32(MD_THREAD_ID_FAULT + t);
+        Put32(0);                       // SuspendCount
+        Put32(0);                       // PriorityClass
+        Put32(0);                       // Priority
+        Put64(0);                       // Teb
+        PutMemoryDescriptor(t == 0 ? stackBlock : taskBlocks[t - 1]);
+        uint32_t location = PutZero(8);
+        if (t == 0)
+            contextLocation = location;
+    }
+    EndStream();
+
+    // MINIDUMP_EXCEPTION_STREAM
+    BeginStream(MD_EXCEPTION_STREAM);
+    Put32(MD_THREAD_ID_FAULT);
+    Put32(0);
+    uint32_t exceptionCode = MD_EXCEPTION_DUMP_REQUESTED;
+    uint32_t exceptionFlags = 0;
+    uint64_t exceptionAddress = 0;
+#ifdef USE_LINUX_SIGNALS
+    if (coreDumpData->SignalNumber != 0)
+    {
+        exceptionCode = (uint32_t)coreDumpData->SignalNumber;
+        exceptionFlags = (uint32_t)coreDumpData->SignalCode;
+        exceptionAddress = coreDumpData->SignalAddress;
+    }
+#endif
+    Put32(exceptionCode);
+    Put32(exceptionFlags);
+    Put64(0);                           // ExceptionRecord
+    Put64(exceptionAddress);
+    Put32(0);                           // NumberParameters
+    Put32(0);
+    PutZero(15 * 8);                    // ExceptionInformation
+    uint32_t exceptionContextLocation = PutZero(8);
+    EndStream();
+
+    // The faulting thread CONTEXT
+    uint32_t context = PutContext(coreDumpData);
+    if (context != 0)
+    {
+        Patch32(contextLocation, MD_CONTEXT_SIZE);
+        Patch32(contextLocation + 4, context);
+        Patch32(exceptionContextLocation, MD_CONTEXT_SIZE);
+        Patch32(exceptionContextLocation + 4, context);
+    }
+
+    PutModuleList(coreDumpData);
+
+    // MINIDUMP_MEMORY_LIST
+    BeginStream(MD_MEMORY_LIST_STREAM);
+    Put32(m_memoryCnt);
+    for (int m = 0; m < m_memoryCnt; m++)
+        PutMemoryDescriptor(m);
+    EndStream();
+
+    Patch32(streamCntOffset, m_streamCnt);
+    if (m_overflow)
+        return false;
+
+    // Memory follows the metadata
+    uint32_t rva = m_used;
+    for (int m = 0; m < m_memoryCnt; m++)
+    {
+        m_memory[m].Rva = rva;
+        rva += m_memory[m].Length;
+    }
+    for (int p = 0; p < m_rvaPatchCnt; p++)
+        Patch32(m_rvaPatch[p], m_memory[m_rvaBlock[p]].Rva);
+
+    return Flush(fd);
+}
+
+// Write the metadata and memory blocks front to back. Each pwritev() call
+// writes at most MINIDUMP_MAX_IOV pieces and MINIDUMP_WRITE_LIMIT bytes.
+bool MinidumpWriter::Flush(int fd)
+{
+    int piece = 0;          // 0 is the metadata, then each memory block
+    uint32_t pieceOffset = 0;
+    uint64_t fileOffset = 0;
+    const int pieceCnt = 1 + m_memoryCnt;
+
+    while (piece < pieceCnt)
+    {
+        int iovCnt = 0;
+        size_t total = 0;
+        int p = piece;
+        uint32_t offset = pieceOffset;
+        while (p < pieceCnt && iovCnt < MINIDUMP_MAX_IOV && total < MINIDUMP_WRITE_LIMIT)
+        {
+            const uint8_t* data = p == 0 ? m_meta : m_memory[p - 1].Data;
+            uint32_t length = p == 0 ? m_used : m_memory[p - 1].Length;
+            size_t count = length - offset;
+            if (count > MINIDUMP_WRITE_LIMIT - total)
+                count = MINIDUMP_WRITE_LIMIT - total;
+
+            m_iov[iovCnt].iov_base = (void*)(data + offset);
+            m_iov[iovCnt].iov_len = count;
+            iovCnt++;
+            total += count;
+            offset += count;
+            if (offset == length)
+            {
+                p++;
+                offset = 0;
+            }
+        }
+
+        ssize_t written = pwritev(fd, m_iov, iovCnt, fileOffset);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        fileOffset += written;
+
+        // Advance by the bytes written; a short write resumes mid piece
+        size_t remaining = written;
+        while (remaining > 0)
+        {
+            uint32_t length = piece == 0 ? m_used : m_memory[piece - 1].Length;
+            size_t count = length - pieceOffset;
+            if (remaining < count)
+            {
+                pieceOffset += remaining;
+                break;
+            }
+            remaining -= count;
+            piece++;
+            pieceOffset = 0;
+        }
+    }
+
+    // Remove any previous contents beyond the new minidump
+    return ftruncate(fd, fileOffset) == 0;
+}
+
+#endif
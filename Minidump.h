@@ -0,0 +1,105 @@
+#ifndef _MINIDUMP_H
+#define _MINIDUMP_H
+
+// Breakpad/Crashpad compatible minidump writer. Converts a CoreDumpData
+// structure into a minidump holding the system information, the faulting
+// thread registers and stack slice, OS task stacks, the exception record,
+// all captured memory regions and, with USE_MODULE_RELATIVE_STACK, the
+// module list with build-ids for symbolization. Memory is written directly
+// from the CoreDumpData structure; the file is written front to back with
+// pwritev().
+
+#ifdef __linux__
+
+#include "CoreDump.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+// Maximum bytes written by a single pwritev() call
+#define MINIDUMP_WRITE_LIMIT    (64 * 1024)
+
+#define MINIDUMP_MAX_STREAMS    5
+#define MINIDUMP_MAX_THREADS    (1 + OS_TASKCNT)
+
+#ifdef USE_MODULE_RELATIVE_STACK
+#define MINIDUMP_MAX_MODULES    MAX_STACK_MODULES
+#else
+#define MINIDUMP_MAX_MODULES    0
+#endif
+
+// Stack slice plus memory regions
+#ifdef USE_MEMORY_REGIONS
+#define MINIDUMP_MAX_MEMORY     (1 + MAX_STORED_REGIONS)
+#else
+#define MINIDUMP_MAX_MEMORY     1
+#endif
+
+// Serialized header, directory, streams, thread contexts and module records
+#define MINIDUMP_META_SIZE      (4096 + MINIDUMP_MAX_THREADS * 1232 + MINIDUMP_MAX_MODULES * 256)
+
+#define MINIDUMP_MAX_IOV        64
+
+class MinidumpWriter
+{
+public:
+    MinidumpWriter();
+
+    /// Write a minidump. No memory is allocated.
+    /// @param[in] fd - the output file, written from offset 0
+    /// @param[in] coreDumpData - the core dump to convert
+    /// @return True if successful.
+    bool Write(int fd, const CoreDumpData* coreDumpData);
+
+private:
+    MinidumpWriter(const MinidumpWriter&) = delete;
+    MinidumpWriter& operator=(const MinidumpWriter&) = delete;
+
+    /// A block of captured memory written after the metadata
+    struct MemoryBlock
+    {
+        uint64_t Address;
+        const uint8_t* Data;
+        uint32_t Length;
+        uint32_t Rva;
+    };
+
+    void Reset();
+    uint32_t Put32(uint32_t value);
+    uint32_t Put16(uint16_t value);
+    uint32_t Put64(uint64_t value);
+    uint32_t PutZero(uint32_t count);
+    void Align(uint32_t alignment);
+    void Patch32(uint32_t offset, uint32_t value);
+    void Patch64(uint32_t offset, uint64_t value);
+
+    int AddMemory(uint64_t address, const void* data, uint32_t length);
+    uint32_t PutContext(const CoreDumpData* coreDumpData);
+    void PutModuleList(const CoreDumpData* coreDumpData);
+    void PutMemoryDescriptor(int block);
+    void BeginStream(uint32_t type);
+    void EndStream();
+
+    bool Flush(int fd);
+
+    uint8_t m_meta[MINIDUMP_META_SIZE];
+    uint32_t m_used;
+    bool m_overflow;
+
+    uint32_t m_directory;       // Offset of the stream directory
+    int m_streamCnt;
+    uint32_t m_streamStart;
+
+    MemoryBlock m_memory[MINIDUMP_MAX_MEMORY];
+    int m_memoryCnt;
+
+    // Memory descriptor RVA fields to patch once the metadata size is known
+    uint32_t m_rvaPatch[MINIDUMP_MAX_MEMORY + MINIDUMP_MAX_THREADS];
+    int m_rvaBlock[MINIDUMP_MAX_MEMORY + MINIDUMP_MAX_THREADS];
+    int m_rvaPatchCnt;
+
+    struct iovec m_iov[MINIDUMP_MAX_IOV];
+};
+
+#endif
+#endif
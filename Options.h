@@ -21,9 +21,87 @@
 #define USE_LINUX_BACKTRACE
 #endif
 
+// Define to capture registers and fault addresses using Linux fatal signal 
+// handlers (SIGSEGV, SIGBUS, SIGFPE, SIGILL)
+#ifdef __linux__
+#define USE_LINUX_SIGNALS
+#endif
+
 // Define to use Windows backtrace method. Must link with DbgHelp.lib.
 #ifdef WIN32
 #define USE_WINDOWS_BACKTRACE
 #endif
 
+// Define to store registered memory regions (global state, stack tops, memory
+// around faulting addresses) within the core dump
+//#define USE_MEMORY_REGIONS
+
+// Define to store a raw stack window and unwind registers within the core dump
+// for offline unwinding by the decoder
+//#define USE_STACK_SLICE
+
+// Define to store the active call stack as (module index, 32-bit offset) 
+// pairs with a module table of build-ids and load bases
+//#define USE_MODULE_RELATIVE_STACK
+
+// Define to forward a saved core dump to the local crash collector daemon 
+// (Collector/) at startup. Linux only.
+//#define USE_COLLECTOR
+
+// Define to persist a saved core dump at startup and upload persisted core 
+// dumps to the collector from a low priority, rate limited background thread.
+// Requires USE_COLLECTOR.
+//#define USE_UPLOADER
+
+// Define to detect a saved core dump at boot with a single cache line read 
+// and persist it from a deferred task. Core dumps are double-buffered so a
+// fault during persistence does not overwrite the unpersisted core dump.
+//#define USE_FAST_BOOT
+
+// Define to protect the core dump with Hamming SECDED check bytes stored 
+// alongside it in no-init RAM. Single bit errors are repaired at boot.
+//#define USE_ECC_STORAGE
+
+// Define to register each ASSERT site in a linker section with a dense 16-bit
+// id and a failure counter. The core dump stores the site id instead of the
+// file name. GCC or Clang ELF targets only.
+//#define USE_ASSERT_SITES
+
+// Define to record the peak usage of each stack painted using 
+// StackPaintRegister() within the core dump
+//#define USE_STACK_PAINT
+
+// Define to limit the call stack search and stack copies to the exact thread
+// stack bounds registered using StackBoundsRegisterThread()
+//#define USE_STACK_BOUNDS
+
+// Define to validate memory reads made while storing a core dump against the
+// cached mapping and stack tables, probing unknown memory without faulting.
+// With USE_LINUX_SIGNALS and USE_MEMORY_REGIONS, also stores the memory 
+// around a fault address.
+//#define USE_SAFE_READ
+
+// Define to store the active call stack from a per-thread shadow stack kept
+// by -finstrument-functions. Compile the selected modules with 
+// -finstrument-functions. GCC or Clang only.
+//#define USE_SHADOW_STACK
+
+// Define to store the last functions entered by the faulting thread, recorded
+// by -finstrument-functions or FUNCTION_HISTORY_MARK(). GCC or Clang ELF 
+// targets only.
+//#define USE_FUNCTION_HISTORY
+
+// Define to run the SIGPROF sampling profiler (Profiler.h) writing folded 
+// call stacks for flame graphs. Linux only.
+//#define USE_PROFILER
+
+// Define to capture live snapshots of all thread call stacks (Snapshot.h) on
+// SIGUSR2 into snapshot.store without stopping the process. Linux only.
+//#define USE_SNAPSHOT
+
+// Define to run the wall-clock sampling profiler (WallProfiler.h) sampling 
+// every thread, running or blocked, and writing folded call stacks for 
+// off-CPU flame graphs. Linux only.
+//#define USE_WALL_PROFILER
+
 #endif 
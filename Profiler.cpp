@@ -0,0 +1,314 @@
+#include "Profiler.h"
+
+#ifdef __linux__
+
+#include "Fault.h"
+#include "SlotRegistry.h"
+#include "StackCapture.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+static_assert((PROFILER_RING_SIZE & (PROFILER_RING_SIZE - 1)) == 0,
+    "PROFILER_RING_SIZE must be a power of 2");
+
+// No longer sampled; freed once the drainer has read its samples
+#define SLOT_RETIRED        (SLOT_ACTIVE + 1)
+
+/// One call stack sample, innermost frame first
+struct ProfilerSample
+{
+    uint32_t Depth;
+    INTEGER_TYPE Frames[PROFILER_STACK_DEPTH];
+};
+
+/// A registered thread. The signal handler on the thread writes samples at
+/// Head; the drainer reads them at Tail.
+struct alignas(64) ProfilerThread
+{
+    std::atomic<int> State;
+    std::atomic<pid_t> ThreadId;    // The thread that claimed the slot
+    std::atomic<uint32_t> Head;
+    std::atomic<uint32_t> Tail;
+    timer_t Timer;
+    ProfilerSample Samples[PROFILER_RING_SIZE];
+};
+
+static ProfilerThread _threads[PROFILER_MAX_THREADS];
+static thread_local int _threadIdx __attribute__((tls_model("initial-exec"))) = -1;
+static thread_local pid_t _threadId __attribute__((tls_model("initial-exec"))) = 0;
+
+static ProfilerConfig _config;
+static std::atomic<bool> _running(false);
+static struct sigaction _previousAction;
+
+static std::thread _drainer;
+static std::mutex _lock;
+static std::condition_variable _wake;
+static bool _stop = false;
+
+// Aggregated call stacks, innermost frame first. Guarded by _lock.
+static std::map<std::vector<INTEGER_TYPE>, uint64_t> _stacks;
+
+static std::atomic<uint64_t> _samples(0);
+static std::atomic<uint64_t> _dropped(0);
+
+static void ProfilerSignalHandler(int signalNumber, siginfo_t* signalInfo, void* userContext)
+{
+    (void)signalNumber;
+    (void)signalInfo;
+
+    int idx = _threadIdx;
+    if (idx < 0 || !_running.load(std::memory_order_relaxed))
+        return;
+
+    ProfilerThread* thread = &_threads[idx];
+    if (!SlotActive(&thread->State) || thread->ThreadId.load(std::memory_order_relaxed) != _threadId)
+        return;
+
+    // Single producer; only this thread writes Head
+    uint32_t head = thread->Head.load(std::memory_order_relaxed);
+    if (head - thread->Tail.load(std::memory_order_acquire) >= PROFILER_RING_SIZE)
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    int savedErrno = errno;
+    ProfilerSample* sample = &thread->Samples[head & (PROFILER_RING_SIZE - 1)];
+    sample->Depth = StackCaptureSignal(userContext, sample->Frames, PROFILER_STACK_DEPTH);
+    thread->Head.store(head + 1, std::memory_order_release);
+    _samples.fetch_add(1, std::memory_order_relaxed);
+    errno = savedErrno;
+}
+
+// Move the buffered samples of all threads into the aggregated call stacks
+static void DrainSamples()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    for (int t = 0; t < PROFILER_MAX_THREADS; t++)
+    {
+        ProfilerThread* thread = &_threads[t];
+        int state = thread->State.load(std::memory_order_acquire);
+        if (state != SLOT_ACTIVE && state != SLOT_RETIRED)
+            continue;
+
+        uint32_t tail = thread->Tail.load(std::memory_order_relaxed);
+        uint32_t head = thread->Head.load(std::memory_order_acquire);
+        for (; tail != head; tail++)
+        {
+            const ProfilerSample* sample = &thread->Samples[tail & (PROFILER_RING_SIZE - 1)];
+            std::vector<INTEGER_TYPE> stack(sample->Frames, sample->Frames + sample->Depth);
+            _stacks[stack]++;
+        }
+        thread->Tail.store(tail, std::memory_order_release);
+
+        // A retired thread is free once drained
+        if (state == SLOT_RETIRED)
+            SlotRelease(&thread->State);
+    }
+}
+
+static void DrainerThread()
+{
+#ifdef USE_LINUX_SIGNALS
+    SignalFaultThread signalFaultThread;
+#endif
+    std::unique_lock<std::mutex> lock(_lock);
+    while (!_stop)
+    {
+        _wake.wait_for(lock, std::chrono::milliseconds(_config.DrainIntervalMs));
+        lock.unlock();
+        DrainSamples();
+        lock.lock();
+    }
+}
+
+// Returns true if this thread still owns its registered slot. A slot is
+// freed when the profiler stops; after a restart another thread may have
+// claimed it.
+static bool OwnsSlot(int idx)
+{
+    return idx >= 0 && SlotActive(&_threads[idx].State) &&
+        _threads[idx].ThreadId.load(std::memory_order_relaxed) == _threadId;
+}
+
+// Stop sampling a thread. Only the caller moving the slot out of SLOT_ACTIVE
+// deletes the timer.
+static void RetireThread(ProfilerThread* thread)
+{
+    int expected = SLOT_ACTIVE;
+    if (thread->State.compare_exchange_strong(expected, SLOT_RETIRED))
+        timer_delete(thread->Timer);
+}
+
+bool ProfilerStart(const ProfilerConfig* config)
+{
+    if (_running || _drainer.joinable() || config->SampleHz == 0)
+        return false;
+
+    _config = *config;
+    if (_config.DrainIntervalMs == 0)
+        _config.DrainIntervalMs = PROFILER_DRAIN_MS;
+
+    StackCaptureInit();
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = ProfilerSignalHandler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &_previousAction) != 0)
+        return false;
+
+    _stop = false;
+    _running = true;
+    _drainer = std::thread(DrainerThread);
+    if (!ProfilerRegisterThread())
+    {
+        ProfilerStop();
+        return false;
+    }
+    return true;
+}
+
+void ProfilerStop()
+{
+    if (!_drainer.joinable())
+        return;
+
+    _running = false;
+    for (int t = 0; t < PROFILER_MAX_THREADS; t++)
+        RetireThread(&_threads[t]);
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _stop = true;
+    }
+    _wake.notify_all();
+    _drainer.join();
+
+    // A handler already running completes its sample before the drain
+    DrainSamples();
+    sigaction(SIGPROF, &_previousAction, NULL);
+}
+
+bool ProfilerRegisterThread()
+{
+    if (!_running)
+        return false;
+    if (OwnsSlot(_threadIdx))
+        return true;
+    _threadIdx = -1;
+    _threadId = (pid_t)syscall(SYS_gettid);
+
+    for (int t = 0; t < PROFILER_MAX_THREADS; t++)
+    {
+        ProfilerThread* thread = &_threads[t];
+        if (!SlotClaim(&thread->State))
+            continue;
+
+        thread->ThreadId.store(_threadId, std::memory_order_relaxed);
+        thread->Head.store(0, std::memory_order_relaxed);
+        thread->Tail.store(0, std::memory_order_relaxed);
+
+        // Sample on this thread's CPU time; the signal is directed at this thread
+        struct sigevent event;
+        memset(&event, 0, sizeof(event));
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGPROF;
+        event.sigev_notify_thread_id = _threadId;
+        if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &thread->Timer) != 0)
+        {
+            SlotRelease(&thread->State);
+            return false;
+        }
+
+        // tv_nsec must be below one second, e.g. at SampleHz 1
+        uint64_t periodNs = 1000000000ull / _config.SampleHz;
+        struct itimerspec period;
+        period.it_interval.tv_sec = (time_t)(periodNs / 1000000000ull);
+        period.it_interval.tv_nsec = (long)(periodNs % 1000000000ull);
+        period.it_value = period.it_interval;
+        if (timer_settime(thread->Timer, 0, &period, NULL) != 0)
+        {
+            timer_delete(thread->Timer);
+            SlotRelease(&thread->State);
+            return false;
+        }
+
+        // A sample before the slot is active is ignored by the handler
+        _threadIdx = t;
+        SlotPublish(&thread->State);
+        return true;
+    }
+
+    // All slots in use. Increase PROFILER_MAX_THREADS.
+    return false;
+}
+
+void ProfilerUnregisterThread()
+{
+    // A stale slot, freed by ProfilerStop(), may belong to another thread
+    int idx = _threadIdx;
+    _threadIdx = -1;
+    if (OwnsSlot(idx))
+        RetireThread(&_threads[idx]);
+}
+
+bool ProfilerWriteFolded(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+        return false;
+
+    // Call stacks differing only in addresses within the same functions
+    // are merged
+    std::unordered_map<INTEGER_TYPE, std::string> symbols;
+    std::map<std::string, uint64_t> folded;
+    std::unique_lock<std::mutex> lock(_lock);
+    for (const auto& entry : _stacks)
+    {
+        const std::vector<INTEGER_TYPE>& stack = entry.first;
+        folded[StackCaptureFolded(stack.data(), (uint32_t)stack.size(), &symbols)] += entry.second;
+    }
+    lock.unlock();
+
+    for (const auto& entry : folded)
+        fprintf(file, "%s %llu\n", entry.first.c_str(), (unsigned long long)entry.second);
+
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
+
+ProfilerStats ProfilerGetStats()
+{
+    ProfilerStats stats;
+    stats.Samples = _samples;
+    stats.Dropped = _dropped;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        stats.Stacks = _stacks.size();
+    }
+    return stats;
+}
+
+#endif
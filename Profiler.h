@@ -0,0 +1,80 @@
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+// Sampling CPU profiler built on the signal-driven call stack capture. Each
+// registered thread has a CPU time timer (timer_create()) raising SIGPROF
+// at the configured rate. The handler stores the interrupted call stack
+// into a per-thread lock-free ring buffer. A background drainer thread
+// aggregates the samples, and ProfilerWriteFolded() writes them in the
+// folded stack format read by flamegraph.pl:
+//
+//   main;Call1;Call2 42
+//
+// The handler captures the call stack using StackCaptureSignal(). Symbols are
+// resolved by the drainer using dladdr(); link with -rdynamic to name the
+// functions of the executable.
+
+#include "CoreDump.h"
+#include <stdint.h>
+
+#ifdef __linux__
+
+// Default sample rate. Not a multiple of common timer periods.
+#define PROFILER_SAMPLE_HZ      99
+
+// Default drainer period
+#define PROFILER_DRAIN_MS       100
+
+// Maximum number of concurrently registered threads
+#define PROFILER_MAX_THREADS    32
+
+// Samples buffered per thread between drains. Must be a power of 2.
+#define PROFILER_RING_SIZE      128
+
+// Call stack depth stored per sample
+#define PROFILER_STACK_DEPTH    16
+
+/// Profiler configuration
+struct ProfilerConfig
+{
+    uint32_t SampleHz;          // Samples per second of thread CPU time
+    uint32_t DrainIntervalMs;   // Drainer period
+};
+
+/// Profiler statistics
+struct ProfilerStats
+{
+    uint64_t Samples;           // Samples stored by the signal handler
+    uint64_t Dropped;           // Samples lost to a full thread ring buffer
+    uint64_t Stacks;            // Distinct aggregated call stacks
+};
+
+/// Start profiling. Installs the SIGPROF handler, starts the drainer thread
+/// and registers the calling thread.
+/// @param[in] config - the profiler configuration
+/// @return True if started; false if already started or the calling thread
+/// could not be registered.
+bool ProfilerStart(const ProfilerConfig* config);
+
+/// Stop profiling. Stops all thread timers and drains the remaining samples.
+/// The aggregated samples remain available to ProfilerWriteFolded().
+void ProfilerStop();
+
+/// Register the calling thread for sampling. Call at thread start.
+/// @return True if registered; false if not started or PROFILER_MAX_THREADS
+///     are registered.
+bool ProfilerRegisterThread();
+
+/// Unregister the calling thread. Call before the thread exits.
+void ProfilerUnregisterThread();
+
+/// Write the aggregated samples in folded stack format.
+/// @param[in] path - the output file
+/// @return True if written.
+bool ProfilerWriteFolded(const char* path);
+
+/// Get the profiler statistics
+ProfilerStats ProfilerGetStats();
+
+#endif
+#endif
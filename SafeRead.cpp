@@ -0,0 +1,215 @@
+#include "SafeRead.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#ifdef USE_STACK_BOUNDS
+#include "StackBounds.h"
+#endif
+
+#if defined(__linux__)
+#include <cstdio>
+#include <unistd.h>
+#include <sys/uio.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#ifdef __linux__
+/// A readable address range [Begin, End)
+struct Mapping
+{
+    uintptr_t Begin;
+    uintptr_t End;
+};
+
+/// Readable mappings sorted by address. Adjacent mappings are merged.
+struct MappingTable
+{
+    Mapping Mappings[MAX_SAFE_READ_MAPPINGS];
+    int Count;
+};
+
+// Double-buffered so SafeReadInit() does not modify the table in use
+static MappingTable _mappingTables[2];
+static std::atomic<uint32_t> _mappingTableIdx(0);
+
+// Find the cached mapping containing address, or NULL
+static const Mapping* FindMapping(const MappingTable* table, uintptr_t address)
+{
+    // Find the last mapping beginning at or below address
+    int lo = 0;
+    int hi = table->Count;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (table->Mappings[mid].Begin <= address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo > 0 && address < table->Mappings[lo - 1].End)
+        return &table->Mappings[lo - 1];
+    return NULL;
+}
+#endif
+
+// Get the number of bytes from address known to be readable using the cached
+// tables, up to length. Returns 0 if the address is not within any table.
+static size_t ValidLength(uintptr_t address, size_t length)
+{
+#ifdef __linux__
+    const MappingTable* table = &_mappingTables[_mappingTableIdx.load(std::memory_order_acquire) & 1];
+#endif
+
+#ifdef USE_STACK_BOUNDS
+    uintptr_t low, high;
+    if (StackBoundsFind((const void*)address, &low, &high))
+    {
+#ifdef __linux__
+        // The main thread stack bounds span the whole stack size limit, 
+        // including guard and not yet grown pages. Its top is within the 
+        // cached [stack] mapping; only the mapped part is known readable.
+        const Mapping* top = FindMapping(table, high - 1);
+        if (top != NULL)
+            return address >= top->Begin ? std::min(length, (size_t)(high - address)) : 0;
+#endif
+        return std::min(length, (size_t)(high - address));
+    }
+#endif
+
+#ifdef USE_HARDWARE
+    if (address >= RAM_BEGIN && address <= RAM_END)
+        return std::min(length, (size_t)(RAM_END - address + 1));
+    if (address >= FLASH_BASE && address <= FLASH_END)
+        return std::min(length, (size_t)(FLASH_END - address + 1));
+#endif
+
+#ifdef __linux__
+    const Mapping* mapping = FindMapping(table, address);
+    if (mapping != NULL)
+        return std::min(length, (size_t)(mapping->End - address));
+#endif
+
+    (void)address;
+    (void)length;
+    return 0;
+}
+
+// Copy memory not found in the cached tables. Fails instead of faulting if
+// the memory is not mapped.
+static bool ProbeRead(void* dest, uintptr_t src, size_t length)
+{
+#if defined(__linux__)
+    struct iovec local = { dest, length };
+    struct iovec remote = { (void*)src, length };
+    return process_vm_readv(getpid(), &local, 1, &remote, 1, 0) == (ssize_t)length;
+#elif defined(_WIN32)
+    SIZE_T read = 0;
+    return ReadProcessMemory(GetCurrentProcess(), (LPCVOID)src, dest, length, &read) && read == length;
+#else
+    // No recoverable probe. Only memory within the tables is read.
+    (void)dest;
+    (void)src;
+    (void)length;
+    return false;
+#endif
+}
+
+// Bytes from address to the end of its probe page
+static size_t PageRemaining(uintptr_t address)
+{
+    return SAFE_READ_PAGE_SIZE - (address & (SAFE_READ_PAGE_SIZE - 1));
+}
+
+void SafeReadInit()
+{
+#ifdef __linux__
+    uint32_t idx = _mappingTableIdx.load(std::memory_order_relaxed) + 1;
+    MappingTable* table = &_mappingTables[idx & 1];
+    table->Count = 0;
+
+    FILE* maps = fopen("/proc/self/maps", "r");
+    if (maps == NULL)
+        return;
+
+    char line[512];
+    while (fgets(line, sizeof(line), maps) != NULL)
+    {
+        unsigned long begin, end, inode;
+        char perms[5];
+        int nameOffset = 0;
+        if (sscanf(line, "%lx-%lx %4s %*x %*x:%*x %lu %n", &begin, &end, perms, &inode, &nameOffset) < 4)
+            continue;
+
+        // Anonymous mappings (heap, thread stacks) may be unmapped at any
+        // time and are probed instead. The main thread stack only grows.
+        if (perms[0] != 'r')
+            continue;
+        if (inode == 0 && strncmp(line + nameOffset, "[stack]", 7) != 0)
+            continue;
+
+        Mapping* last = table->Count > 0 ? &table->Mappings[table->Count - 1] : NULL;
+        if (last != NULL && last->End == begin)
+        {
+            last->End = end;
+        }
+        else if (table->Count < MAX_SAFE_READ_MAPPINGS)
+        {
+            table->Mappings[table->Count].Begin = begin;
+            table->Mappings[table->Count].End = end;
+            table->Count++;
+        }
+    }
+    fclose(maps);
+
+    _mappingTableIdx.store(idx, std::memory_order_release);
+#endif
+}
+
+bool SafeRead(void* dest, const void* src, size_t length)
+{
+    uint8_t* out = (uint8_t*)dest;
+    uintptr_t address = (uintptr_t)src;
+
+    while (length > 0)
+    {
+        size_t valid = ValidLength(address, length);
+        if (valid != 0)
+        {
+            memcpy(out, (const void*)address, valid);
+        }
+        else
+        {
+            valid = std::min(length, PageRemaining(address));
+            if (!ProbeRead(out, address, valid))
+                return false;
+        }
+        out += valid;
+        address += valid;
+        length -= valid;
+    }
+    return true;
+}
+
+size_t SafeReadExtent(const void* address, size_t length)
+{
+    uintptr_t begin = (uintptr_t)address;
+    size_t extent = 0;
+
+    while (extent < length)
+    {
+        uintptr_t current = begin + extent;
+        size_t valid = ValidLength(current, length - extent);
+        if (valid == 0)
+        {
+            // One byte read proves the whole page is readable
+            uint8_t byte;
+            if (!ProbeRead(&byte, current, 1))
+                break;
+            valid = std::min(length - extent, PageRemaining(current));
+        }
+        extent += valid;
+    }
+    return extent;
+}
@@ -0,0 +1,44 @@
+#ifndef _SAFE_READ_H
+#define _SAFE_READ_H
+
+// Fault tolerant memory reads for the core dump capture path. A corrupt stack
+// pointer or frame pointer must not cause a nested fault inside the fault
+// handler; the fatal signals are blocked while it runs, so a nested fault
+// kills the process and the core dump is lost.
+//
+// Each read is first validated against cached tables: the registered thread
+// stacks (USE_STACK_BOUNDS), the file backed mappings read from
+// /proc/self/maps and the RAM/flash ranges (USE_HARDWARE). A validated read
+// is a table lookup and a memcpy(). Memory not found in any table is probed
+// using process_vm_readv() on Linux or ReadProcessMemory() on Windows, which
+// fail rather than fault on an unmapped address.
+
+#include "CoreDump.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Maximum number of cached file backed mappings
+#define MAX_SAFE_READ_MAPPINGS  256
+
+// Probe granularity in bytes. The smallest page size supported.
+#define SAFE_READ_PAGE_SIZE     4096
+
+/// Cache the file backed mappings (executable, shared libraries) and the main
+/// thread stack. Call at startup and after loading or unloading a shared
+/// library. Not thread safe with respect to itself.
+void SafeReadInit();
+
+/// Copy memory that may not be mapped. Async-signal-safe.
+/// @param[out] dest - the destination buffer
+/// @param[in] src - the source address
+/// @param[in] length - the number of bytes to copy
+/// @return True if copied; false if any source byte is not readable.
+bool SafeRead(void* dest, const void* src, size_t length);
+
+/// Get the number of readable bytes starting at an address. Async-signal-safe.
+/// @param[in] address - the start address
+/// @param[in] length - the maximum number of bytes
+/// @return The number of bytes from address that are readable, up to length.
+size_t SafeReadExtent(const void* address, size_t length);
+
+#endif
@@ -0,0 +1,158 @@
+#include "ShadowStack.h"
+#include <cstring>
+
+static_assert((SHADOW_STACK_SIZE & (SHADOW_STACK_SIZE - 1)) == 0,
+    "SHADOW_STACK_SIZE must be a power of 2");
+static_assert((FUNCTION_HISTORY_SIZE & (FUNCTION_HISTORY_SIZE - 1)) == 0,
+    "FUNCTION_HISTORY_SIZE must be a power of 2");
+
+// The hooks rely on -finstrument-functions and GNU attributes
+#if (defined(USE_SHADOW_STACK) || defined(USE_FUNCTION_HISTORY)) && !defined(__GNUC__)
+#error "USE_SHADOW_STACK and USE_FUNCTION_HISTORY require GCC or Clang"
+#endif
+
+#if defined(__GNUC__)
+#define NO_INSTRUMENT __attribute__((no_instrument_function))
+#define NO_INLINE __attribute__((noinline))
+#endif
+
+#ifdef USE_SHADOW_STACK
+/// A per-thread shadow stack. Entries grow down from the end of Frames so
+/// the innermost entries are contiguous, most recent first.
+struct ShadowStack
+{
+    uint32_t Depth;
+    INTEGER_TYPE Frames[SHADOW_STACK_SIZE];
+};
+
+// Zero initialized, so no TLS constructor or guard on access
+static thread_local ShadowStack _shadowStack __attribute__((tls_model("initial-exec")));
+#endif
+
+#ifdef USE_FUNCTION_HISTORY
+/// A per-thread ring of function entry offsets from __ehdr_start
+struct FunctionHistory
+{
+    uint32_t Index;
+    uint32_t Entries[FUNCTION_HISTORY_SIZE];
+};
+
+static thread_local FunctionHistory _functionHistory __attribute__((tls_model("initial-exec")));
+
+// The ELF header of this executable (or shared library) defined by the
+// linker. Its address is the load address.
+extern "C" const char __ehdr_start[] __attribute__((visibility("hidden")));
+
+static inline NO_INSTRUMENT void RecordFunction(const void* address)
+{
+    FunctionHistory* history = &_functionHistory;
+    history->Entries[history->Index++ & (FUNCTION_HISTORY_SIZE - 1)] =
+        (uint32_t)((uintptr_t)address - (uintptr_t)__ehdr_start);
+}
+#endif
+
+#if defined(USE_SHADOW_STACK) || defined(USE_FUNCTION_HISTORY)
+extern "C" NO_INSTRUMENT void __cyg_profile_func_enter(void* function, void* callSite)
+{
+    (void)function;
+    (void)callSite;
+#ifdef USE_SHADOW_STACK
+    ShadowStack* stack = &_shadowStack;
+    uint32_t depth = stack->Depth++;
+    stack->Frames[~depth & (SHADOW_STACK_SIZE - 1)] = (INTEGER_TYPE)callSite;
+#endif
+#ifdef USE_FUNCTION_HISTORY
+    RecordFunction(function);
+#endif
+}
+
+extern "C" NO_INSTRUMENT void __cyg_profile_func_exit(void* function, void* callSite)
+{
+    (void)function;
+    (void)callSite;
+#ifdef USE_SHADOW_STACK
+    _shadowStack.Depth--;
+#endif
+}
+#endif
+
+#ifdef USE_SHADOW_STACK
+NO_INSTRUMENT int ShadowStackCopy(INTEGER_TYPE* callStack, int maxCnt)
+{
+    const ShadowStack* stack = &_shadowStack;
+    uint32_t depth = stack->Depth;
+    uint32_t cnt = depth < SHADOW_STACK_SIZE ? depth : SHADOW_STACK_SIZE;
+    if (cnt > (uint32_t)maxCnt)
+        cnt = (uint32_t)maxCnt;
+
+    // The innermost entry; the copy wraps only once the stack is deeper
+    // than SHADOW_STACK_SIZE
+    uint32_t begin = (SHADOW_STACK_SIZE - depth) & (SHADOW_STACK_SIZE - 1);
+    uint32_t first = SHADOW_STACK_SIZE - begin < cnt ? SHADOW_STACK_SIZE - begin : cnt;
+    memcpy(callStack, &stack->Frames[begin], first * sizeof(INTEGER_TYPE));
+    if (first < cnt)
+        memcpy(callStack + first, &stack->Frames[0], (cnt - first) * sizeof(INTEGER_TYPE));
+    memset(callStack + cnt, 0, (maxCnt - cnt) * sizeof(INTEGER_TYPE));
+    return (int)cnt;
+}
+
+NO_INSTRUMENT uint32_t ShadowStackDepth()
+{
+    return _shadowStack.Depth;
+}
+#else
+// USE_SHADOW_STACK not defined; no shadow stack is recorded
+int ShadowStackCopy(INTEGER_TYPE* callStack, int maxCnt)
+{
+    memset(callStack, 0, maxCnt * sizeof(INTEGER_TYPE));
+    return 0;
+}
+
+uint32_t ShadowStackDepth()
+{
+    return 0;
+}
+#endif
+
+#ifdef USE_FUNCTION_HISTORY
+NO_INSTRUMENT NO_INLINE void FunctionHistoryMark()
+{
+    // An address within the marked function
+    RecordFunction(__builtin_return_address(0));
+}
+
+NO_INSTRUMENT int FunctionHistoryCopy(uint32_t* history, int maxCnt)
+{
+    const FunctionHistory* ring = &_functionHistory;
+    uint32_t index = ring->Index;
+    uint32_t cnt = index < FUNCTION_HISTORY_SIZE ? index : FUNCTION_HISTORY_SIZE;
+    if (cnt > (uint32_t)maxCnt)
+        cnt = (uint32_t)maxCnt;
+
+    for (uint32_t h = 0; h < cnt; h++)
+        history[h] = ring->Entries[(index - 1 - h) & (FUNCTION_HISTORY_SIZE - 1)];
+    memset(history + cnt, 0, (maxCnt - cnt) * sizeof(uint32_t));
+    return (int)cnt;
+}
+
+NO_INSTRUMENT uint64_t FunctionHistoryBase()
+{
+    return (uint64_t)(uintptr_t)__ehdr_start;
+}
+#else
+// USE_FUNCTION_HISTORY not defined; no function history is recorded
+void FunctionHistoryMark()
+{
+}
+
+int FunctionHistoryCopy(uint32_t* history, int maxCnt)
+{
+    memset(history, 0, maxCnt * sizeof(uint32_t));
+    return 0;
+}
+
+uint64_t FunctionHistoryBase()
+{
+    return 0;
+}
+#endif
@@ -0,0 +1,62 @@
+#ifndef _SHADOW_STACK_H
+#define _SHADOW_STACK_H
+
+// Function instrumentation using -finstrument-functions.
+//
+// Shadow call stack (USE_SHADOW_STACK): each instrumented function entry
+// pushes its return address onto a fixed-size per-thread stack and each exit
+// pops it, so the call stack is known exactly at fault time without
+// unwinding.
+//
+// Function history (USE_FUNCTION_HISTORY): each instrumented function entry,
+// or FUNCTION_HISTORY_MARK(), records the function address into a per-thread
+// ring of the last FUNCTION_HISTORY_SIZE entries, including functions that
+// already returned. Addresses are stored as 32-bit offsets from the
+// executable load address.
+//
+// Compile only the selected modules with -finstrument-functions, e.g. using
+// CMake:
+//
+//   set_source_files_properties(Module.cpp PROPERTIES COMPILE_OPTIONS -finstrument-functions)
+//
+// Each hook is one initial-exec TLS access, an increment or decrement and
+// a store. Uninstrumented frames do not appear on the shadow stack.
+
+#include "CoreDump.h"
+#include <stdint.h>
+
+// Shadow stack entries per thread. Must be a power of 2. Deeper call chains
+// overwrite the oldest entries.
+#define SHADOW_STACK_SIZE       64
+
+// Record the current location into the function history of the calling
+// thread without compiler instrumentation
+#define FUNCTION_HISTORY_MARK()     FunctionHistoryMark()
+
+/// Copy the innermost shadow stack entries of the calling thread, most
+/// recent first. Unused entries are cleared. Async-signal-safe.
+/// @param[out] callStack - the destination array
+/// @param[in] maxCnt - the destination array length
+/// @return The number of entries copied. 0 if no instrumented function is active.
+int ShadowStackCopy(INTEGER_TYPE* callStack, int maxCnt);
+
+/// Get the shadow stack depth of the calling thread
+/// @return The number of active instrumented functions.
+uint32_t ShadowStackDepth();
+
+/// Record the caller location into the function history. Use
+/// FUNCTION_HISTORY_MARK().
+void FunctionHistoryMark();
+
+/// Copy the function history of the calling thread, most recent first.
+/// Unused entries are cleared. Async-signal-safe.
+/// @param[out] history - the destination array of offsets from FunctionHistoryBase()
+/// @param[in] maxCnt - the destination array length
+/// @return The number of entries copied.
+int FunctionHistoryCopy(uint32_t* history, int maxCnt);
+
+/// Get the address function history offsets are relative to
+/// @return The executable load address.
+uint64_t FunctionHistoryBase();
+
+#endif
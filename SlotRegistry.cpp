@@ -0,0 +1,22 @@
+#include "SlotRegistry.h"
+
+bool SlotClaim(std::atomic<int>* state)
+{
+    int expected = SLOT_FREE;
+    return state->compare_exchange_strong(expected, SLOT_CLAIMED);
+}
+
+void SlotPublish(std::atomic<int>* state)
+{
+    state->store(SLOT_ACTIVE, std::memory_order_release);
+}
+
+void SlotRelease(std::atomic<int>* state)
+{
+    state->store(SLOT_FREE, std::memory_order_release);
+}
+
+bool SlotActive(const std::atomic<int>* state)
+{
+    return state->load(std::memory_order_acquire) == SLOT_ACTIVE;
+}
@@ -0,0 +1,34 @@
+#ifndef _SLOT_REGISTRY_H
+#define _SLOT_REGISTRY_H
+
+// Lock-free slot protocol shared by the fixed-size registries (StackBounds,
+// StackPaint, Profiler). A registering thread claims a free slot, fills it
+// in, then publishes it. Readers, including signal handlers, only use 
+// published slots. All functions are async-signal-safe.
+
+#include <atomic>
+
+// Slot states
+#define SLOT_FREE       0
+#define SLOT_CLAIMED    1       // Being filled in by the claiming thread
+#define SLOT_ACTIVE     2       // Published to readers
+
+/// Claim a free slot.
+/// @param[in] state - the slot state
+/// @return True if claimed. Fill in the slot, then call SlotPublish().
+bool SlotClaim(std::atomic<int>* state);
+
+/// Publish a claimed slot. The slot contents written before are visible to
+/// a reader once SlotActive() returns true.
+/// @param[in] state - the slot state
+void SlotPublish(std::atomic<int>* state);
+
+/// Free a claimed or published slot.
+/// @param[in] state - the slot state
+void SlotRelease(std::atomic<int>* state);
+
+/// Returns true if a slot is published.
+/// @param[in] state - the slot state
+bool SlotActive(const std::atomic<int>* state);
+
+#endif
@@ -0,0 +1,272 @@
+#include "Snapshot.h"
+
+#ifdef __linux__
+
+#include "DumpStore.h"
+#include "Fault.h"
+#include "StackCapture.h"
+#ifdef USE_FUNCTION_HISTORY
+#include "ShadowStack.h"
+#endif
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <errno.h>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// Signal each thread handles to capture its own call stack
+#define SNAPSHOT_CAPTURE_SIGNAL     (SIGRTMIN + 4)
+
+// Signal requesting a snapshot from the snapshot thread
+#define SNAPSHOT_TRIGGER_SIGNAL     SIGUSR2
+
+static DumpStore _store;
+static SnapshotData _snapshot;
+static std::mutex _lock;
+static bool _installed = false;
+static uint64_t _sequence = 0;
+
+static struct sigaction _previousCapture;
+static struct sigaction _previousTrigger;
+
+// Snapshot thread wake up. sem_post() is async-signal-safe.
+static sem_t _request;
+static std::thread _thread;
+static std::atomic<bool> _stop(false);
+
+// Captures written by the signal handlers. A completed capture is copied
+// into _snapshot; one still writing after the drain wait is never read.
+static SnapshotThread _captures[SNAPSHOT_MAX_THREADS];
+
+// Capture in progress. A thread claims a _captures entry before checking
+// _collecting, so once _collecting is cleared every claimed entry is counted
+// in _claimed and no new entry is written.
+static std::atomic<bool> _collecting(false);
+static std::atomic<uint32_t> _claimed(0);
+static std::atomic<uint32_t> _done(0);
+
+static uint64_t ClockNs(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void CaptureSignalHandler(int signalNumber, siginfo_t* signalInfo, void* userContext)
+{
+    (void)signalNumber;
+    (void)signalInfo;
+    int savedErrno = errno;
+
+    uint32_t idx = _claimed.fetch_add(1);
+    if (_collecting.load() && idx < SNAPSHOT_MAX_THREADS)
+    {
+        SnapshotThread* thread = &_captures[idx];
+        thread->Depth = StackCaptureSignal(userContext, thread->CallStack, SNAPSHOT_STACK_DEPTH);
+#ifdef USE_FUNCTION_HISTORY
+        thread->FunctionHistoryBase = FunctionHistoryBase();
+        thread->FunctionHistoryCount = FunctionHistoryCopy(thread->FunctionHistory, FUNCTION_HISTORY_SIZE);
+#endif
+        // Published last; marks the entry complete
+        __atomic_store_n(&thread->ThreadId, (uint32_t)syscall(SYS_gettid), __ATOMIC_RELEASE);
+    }
+    _done.fetch_add(1, std::memory_order_release);
+
+    errno = savedErrno;
+}
+
+// Wait for the claimed captures to complete. Returns false if a capture is
+// still writing after timeoutMs.
+static bool WaitCaptures(uint32_t claimed, uint32_t timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (_done.load(std::memory_order_acquire) < claimed)
+    {
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    return true;
+}
+
+static void TriggerSignalHandler(int signalNumber)
+{
+    (void)signalNumber;
+    sem_post(&_request);
+}
+
+// Read a thread name from /proc
+static void ReadThreadName(uint32_t threadId, char* name)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%u/comm", threadId);
+    memset(name, 0, SNAPSHOT_THREAD_NAME_LEN);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    ssize_t length = read(fd, name, SNAPSHOT_THREAD_NAME_LEN - 1);
+    close(fd);
+    if (length > 0 && name[length - 1] == '\n')
+        name[length - 1] = 0;
+}
+
+// 64-bit FNV-1a over every captured call stack. Identical snapshots are
+// stored once.
+static uint64_t SnapshotHash(const SnapshotData* snapshot)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (uint32_t t = 0; t < snapshot->ThreadCount; t++)
+    {
+        const SnapshotThread* thread = &snapshot->Threads[t];
+        const uint8_t* bytes = (const uint8_t*)thread->CallStack;
+        for (size_t b = 0; b < thread->Depth * sizeof(INTEGER_TYPE); b++)
+        {
+            hash ^= bytes[b];
+            hash *= 0x100000001b3ull;
+        }
+    }
+    return hash;
+}
+
+static void SnapshotThreadMain()
+{
+#ifdef USE_LINUX_SIGNALS
+    SignalFaultThread signalFaultThread;
+#endif
+    for (;;)
+    {
+        if (sem_wait(&_request) != 0)
+            continue;
+        if (_stop)
+            break;
+        SnapshotTake();
+    }
+}
+
+bool SnapshotInstall(const char* storePath)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    if (_installed)
+        return false;
+    if (!_store.Open(storePath))
+        return false;
+
+    StackCaptureInit();
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = CaptureSignalHandler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SNAPSHOT_CAPTURE_SIGNAL, &action, &_previousCapture);
+
+    sem_init(&_request, 0, 0);
+    _stop = false;
+    _thread = std::thread(SnapshotThreadMain);
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = TriggerSignalHandler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SNAPSHOT_TRIGGER_SIGNAL, &action, &_previousTrigger);
+
+    _installed = true;
+    return true;
+}
+
+void SnapshotUninstall()
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (!_installed)
+            return;
+        sigaction(SNAPSHOT_TRIGGER_SIGNAL, &_previousTrigger, NULL);
+    }
+
+    _stop = true;
+    sem_post(&_request);
+    _thread.join();
+    sem_destroy(&_request);
+
+    // A capture signal still pending on a thread blocking it would terminate
+    // the process under the default action
+    std::lock_guard<std::mutex> lock(_lock);
+    if (!(_previousCapture.sa_flags & SA_SIGINFO) && _previousCapture.sa_handler == SIG_DFL)
+        _previousCapture.sa_handler = SIG_IGN;
+    sigaction(SNAPSHOT_CAPTURE_SIGNAL, &_previousCapture, NULL);
+    _store.Close();
+    _installed = false;
+}
+
+const SnapshotData* SnapshotTake()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    if (!_installed)
+        return NULL;
+
+    // A capture of the previous snapshot still writing owns its entry
+    uint32_t previous = _claimed.load();
+    if (!WaitCaptures(previous, SNAPSHOT_DRAIN_MS))
+        return NULL;
+    if (previous > SNAPSHOT_MAX_THREADS)
+        previous = SNAPSHOT_MAX_THREADS;
+    for (uint32_t t = 0; t < previous; t++)
+        _captures[t].ThreadId = 0;
+
+    memset(&_snapshot, 0, sizeof(_snapshot));
+    _snapshot.Magic = SNAPSHOT_MAGIC;
+    _snapshot.SoftwareVersion = SOFTWARE_VERSION;
+    _snapshot.Sequence = _sequence++;
+    _snapshot.RealtimeNs = ClockNs(CLOCK_REALTIME);
+    _snapshot.MonotonicNs = ClockNs(CLOCK_MONOTONIC);
+
+    _claimed = 0;
+    _done = 0;
+    _collecting = true;
+
+    // Signal every thread, including this one
+    uint32_t sent = StackCaptureSignalAll(SNAPSHOT_CAPTURE_SIGNAL, 0);
+
+    // Bounded wait for the captures
+    WaitCaptures(sent, SNAPSHOT_TIMEOUT_MS);
+
+    // Late captures no longer write; wait for those already writing with
+    // their own bound
+    _collecting = false;
+    uint32_t claimed = _claimed.load();
+    WaitCaptures(claimed, SNAPSHOT_DRAIN_MS);
+
+    _snapshot.PauseNs = ClockNs(CLOCK_MONOTONIC) - _snapshot.MonotonicNs;
+    if (claimed > SNAPSHOT_MAX_THREADS)
+        claimed = SNAPSHOT_MAX_THREADS;
+
+    // Copy the completed captures; one still writing is missed
+    for (uint32_t t = 0; t < claimed; t++)
+    {
+        const SnapshotThread* capture = &_captures[t];
+        if (__atomic_load_n(&capture->ThreadId, __ATOMIC_ACQUIRE) == 0)
+            continue;
+        SnapshotThread* thread = &_snapshot.Threads[_snapshot.ThreadCount++];
+        *thread = *capture;
+        ReadThreadName(thread->ThreadId, thread->Name);
+    }
+    _snapshot.Missed = sent > _snapshot.ThreadCount ? sent - _snapshot.ThreadCount : 0;
+
+    // Only the used Threads entries are stored
+    uint32_t length = (uint32_t)(offsetof(SnapshotData, Threads) + _snapshot.ThreadCount * sizeof(SnapshotThread));
+    _store.Append(&_snapshot, length, SnapshotHash(&_snapshot), 0);
+    _store.Commit();
+    return &_snapshot;
+}
+
+#endif
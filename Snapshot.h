@@ -0,0 +1,94 @@
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+
+// Live snapshot of all thread call stacks. Unlike CoreDumpStore(), a
+// snapshot is not fatal, any number can be taken, and it is stored in its
+// own static slot so a later fault still stores a core dump.
+//
+// SnapshotTake() sends SNAPSHOT_CAPTURE_SIGNAL to every thread of the
+// process using tgkill(). Each thread captures its own call stack (and
+// function history) within the signal handler and continues, so a thread
+// pauses only for its own capture. Threads not responding within
+// SNAPSHOT_TIMEOUT_MS, e.g. stopped or with the signal blocked, are counted
+// as missed, as are captures still writing SNAPSHOT_DRAIN_MS later. The
+// snapshot, holding only the completed Threads entries, is appended to a
+// DumpStore file.
+//
+// SnapshotInstall() also starts a snapshot thread triggered by SIGUSR2:
+//
+//   kill -USR2 <pid>
+//
+// Decode the store using CoreDumpDecoder <store> --snapshots.
+
+#include "CoreDump.h"
+#include <stdint.h>
+
+// Snapshot magic number, the first word of SnapshotData
+#define SNAPSHOT_MAGIC          0x50414E53      // "SNAP"
+
+// Maximum number of threads captured per snapshot
+#define SNAPSHOT_MAX_THREADS    256
+
+// Call stack depth captured per thread
+#define SNAPSHOT_STACK_DEPTH    32
+
+// Maximum time to wait for every thread to capture its call stack
+#define SNAPSHOT_TIMEOUT_MS     100
+
+// Maximum time to then wait for the captures already writing
+#define SNAPSHOT_DRAIN_MS       10
+
+#define SNAPSHOT_THREAD_NAME_LEN    16
+
+// Default snapshot store file. Separate from the core dump store; its
+// records are not core dumps.
+#define SNAPSHOT_STORE_PATH     "snapshot.store"
+
+/// One thread within a snapshot
+struct SnapshotThread
+{
+    uint32_t ThreadId;
+    uint32_t Depth;             // Valid CallStack entries
+    char Name[SNAPSHOT_THREAD_NAME_LEN];
+    INTEGER_TYPE CallStack[SNAPSHOT_STACK_DEPTH];
+#ifdef USE_FUNCTION_HISTORY
+    uint64_t FunctionHistoryBase;
+    uint32_t FunctionHistoryCount;
+    uint32_t FunctionHistory[FUNCTION_HISTORY_SIZE];
+#endif
+};
+
+/// Snapshot of all threads
+struct SnapshotData
+{
+    uint32_t Magic;
+    uint32_t SoftwareVersion;
+    uint64_t Sequence;          // Snapshot number since SnapshotInstall()
+    uint64_t RealtimeNs;        // Wall-clock time since the Unix epoch when the snapshot began
+    uint64_t MonotonicNs;       // CLOCK_MONOTONIC when the snapshot began
+    uint64_t PauseNs;           // Time from the first signal to the last capture
+    uint32_t ThreadCount;       // Valid Threads entries
+    uint32_t Missed;            // Threads that did not respond in time
+    SnapshotThread Threads[SNAPSHOT_MAX_THREADS];
+};
+
+#ifdef __linux__
+
+/// Install the capture signal handler, open the snapshot store and start the
+/// SIGUSR2 triggered snapshot thread.
+/// @param[in] storePath - the snapshot store file, e.g. SNAPSHOT_STORE_PATH
+/// @return True if successful.
+bool SnapshotInstall(const char* storePath);
+
+/// Stop the snapshot thread, restore the previous signal handlers and close
+/// the snapshot store.
+void SnapshotUninstall();
+
+/// Capture all threads and append the snapshot to the store. The process
+/// continues. Not async-signal-safe; raise SIGUSR2 from a signal handler.
+/// @return The snapshot, valid until the next SnapshotTake(); NULL if not 
+/// installed or a capture of the previous snapshot is still writing.
+const SnapshotData* SnapshotTake();
+
+#endif
+#endif
@@ -0,0 +1,163 @@
+#include "SoftAssert.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(__linux__)
+#include <execinfo.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if defined(_MSC_VER)
+#define NO_INLINE __declspec(noinline)
+#else
+#define NO_INLINE __attribute__((noinline))
+#endif
+
+static_assert((SOFT_ASSERT_RING_SIZE & (SOFT_ASSERT_RING_SIZE - 1)) == 0,
+    "SOFT_ASSERT_RING_SIZE must be a power of 2");
+
+/// One ring buffer entry. State is 2 * sequence + 1 while the record is
+/// written and 2 * sequence + 2 once complete.
+struct alignas(64) SoftAssertSlot
+{
+    std::atomic<uint64_t> State;
+    SoftAssertRecord Record;
+};
+
+static SoftAssertSlot _ring[SOFT_ASSERT_RING_SIZE];
+static std::atomic<uint64_t> _next(0);
+
+// Global token bucket state shared by all call sites
+alignas(64) static std::atomic<uint64_t> _globalNextTokenNs(0);
+
+static std::atomic<uint64_t> _recorded(0);
+static std::atomic<uint64_t> _throttled(0);
+
+static uint64_t NowNs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Lock-free token bucket using the generic cell rate algorithm. nextTokenNs
+// is the time the bucket would be full again; a token is available while it
+// is less than burst intervals ahead of now.
+static bool TakeToken(std::atomic<uint64_t>* nextTokenNs, uint64_t now, uint32_t rate, uint32_t burst)
+{
+    const uint64_t interval = 1000000000ull / rate;
+    uint64_t next = nextTokenNs->load(std::memory_order_relaxed);
+    for (;;)
+    {
+        uint64_t updated = std::max(next, now) + interval;
+        if (updated - now > burst * interval)
+            return false;
+        if (nextTokenNs->compare_exchange_weak(next, updated, std::memory_order_relaxed))
+            return true;
+    }
+}
+
+static uint32_t GetThreadId()
+{
+#if defined(__linux__)
+    return (uint32_t)syscall(SYS_gettid);
+#elif defined(_WIN32)
+    return (uint32_t)GetCurrentThreadId();
+#else
+    return 0;
+#endif
+}
+
+static NO_INLINE void SaveCallStack(INTEGER_TYPE* callStack)
+{
+    memset(callStack, 0, sizeof(INTEGER_TYPE) * CALL_STACK_SIZE);
+#if defined(__linux__)
+    // Skip this function and SoftAssertFail()
+    void* frames[CALL_STACK_SIZE + 2];
+    int cnt = backtrace(frames, CALL_STACK_SIZE + 2);
+    for (int f = 2; f < cnt; f++)
+        callStack[f - 2] = (INTEGER_TYPE)frames[f];
+#elif defined(_WIN32)
+    void* frames[CALL_STACK_SIZE];
+    USHORT cnt = CaptureStackBackTrace(2, CALL_STACK_SIZE, frames, NULL);
+    for (USHORT f = 0; f < cnt; f++)
+        callStack[f] = (INTEGER_TYPE)frames[f];
+#elif defined(__GNUC__)
+    callStack[0] = (INTEGER_TYPE)__builtin_return_address(1);
+#endif
+}
+
+void SoftAssertFail(SoftAssertSite* site, const char* file, unsigned short line, uint32_t auxCode)
+{
+    // The only shared write on the hot path; the counter is per call site
+    uint64_t failures = site->Failures.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    uint64_t now = NowNs();
+    if (!TakeToken(&site->NextTokenNs, now, SOFT_ASSERT_SITE_RATE, SOFT_ASSERT_SITE_BURST))
+        return;
+    if (!TakeToken(&_globalNextTokenNs, now, SOFT_ASSERT_GLOBAL_RATE, SOFT_ASSERT_GLOBAL_BURST))
+    {
+        _throttled.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Claim a ring slot. The oldest record is overwritten.
+    uint64_t sequence = _next.fetch_add(1, std::memory_order_relaxed);
+    SoftAssertSlot* slot = &_ring[sequence & (SOFT_ASSERT_RING_SIZE - 1)];
+    slot->State.store(2 * sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SoftAssertRecord* record = &slot->Record;
+    record->Sequence = sequence;
+    record->TimeNs = now;
+
+    // Count this failure plus all unrecorded failures since the last record
+    uint64_t reported = site->Reported.exchange(failures, std::memory_order_relaxed);
+    record->Failures = failures > reported ? failures - reported : 1;
+
+    record->ThreadId = GetThreadId();
+    record->LineNumber = line;
+    record->AuxCode = auxCode;
+
+    // Keep the end of the path; it holds the file name
+    size_t length = file != NULL ? strlen(file) : 0;
+    const char* tail = length >= SOFT_ASSERT_FILE_LEN ? file + length - (SOFT_ASSERT_FILE_LEN - 1) : file;
+    memset(record->FileName, 0, sizeof(record->FileName));
+    if (tail != NULL)
+        memcpy(record->FileName, tail, std::min(length, (size_t)SOFT_ASSERT_FILE_LEN - 1));
+
+    SaveCallStack(record->CallStack);
+
+    slot->State.store(2 * sequence + 2, std::memory_order_release);
+    _recorded.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t SoftAssertNext()
+{
+    return _next.load(std::memory_order_acquire);
+}
+
+bool SoftAssertRead(uint64_t sequence, SoftAssertRecord* record)
+{
+    const SoftAssertSlot* slot = &_ring[sequence & (SOFT_ASSERT_RING_SIZE - 1)];
+    uint64_t state = slot->State.load(std::memory_order_acquire);
+    if (state != 2 * sequence + 2)
+        return false;
+
+    memcpy(record, &slot->Record, sizeof(*record));
+
+    // The record was overwritten during the copy if the state changed
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot->State.load(std::memory_order_relaxed) == state;
+}
+
+SoftAssertStats SoftAssertGetStats()
+{
+    SoftAssertStats stats;
+    stats.Recorded = _recorded.load(std::memory_order_relaxed);
+    stats.Throttled = _throttled.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,88 @@
+#ifndef _SOFT_ASSERT_H
+#define _SOFT_ASSERT_H
+
+// Non-fatal software assertions. A failed ASSERT_SOFT() records a small
+// CoreDumpData-style record (file, line, call stack, thread, time) into an
+// in-memory ring buffer and execution continues. Each call site has its own
+// lock-free failure counter and token bucket, and all sites share a global
+// token bucket, so a hot failing check in a loop records a few samples per
+// second and costs a counter increment and a clock read otherwise. Failures
+// not recorded are counted in the next record from the same site.
+
+#include "CoreDump.h"
+#include <stdint.h>
+#include <atomic>
+
+// Number of records held by the ring buffer. Must be a power of 2.
+#define SOFT_ASSERT_RING_SIZE       256
+
+// Per call site token bucket: records per second and burst
+#define SOFT_ASSERT_SITE_RATE       10
+#define SOFT_ASSERT_SITE_BURST      5
+
+// Global token bucket shared by all call sites
+#define SOFT_ASSERT_GLOBAL_RATE     100
+#define SOFT_ASSERT_GLOBAL_BURST    50
+
+// File name characters stored per record; the end of the path is kept
+#define SOFT_ASSERT_FILE_LEN        48
+
+#define ASSERT_SOFT(condition) \
+    do { \
+        if (!(condition)) { \
+            static SoftAssertSite _softAssertSite; \
+            SoftAssertFail(&_softAssertSite, __FILE__, (unsigned short)__LINE__, 0); \
+        } \
+    } while (0)
+
+/// Per call site state. Zero initialized static storage; no registration.
+struct SoftAssertSite
+{
+    std::atomic<uint64_t> Failures;     // Total failures at this site
+    std::atomic<uint64_t> Reported;     // Failures covered by earlier records
+    std::atomic<uint64_t> NextTokenNs;  // Token bucket state (see TakeToken())
+};
+
+/// A non-fatal assertion record
+struct SoftAssertRecord
+{
+    uint64_t Sequence;          // Ring position written, starting at 0
+    uint64_t TimeNs;            // steady_clock time of the failure
+    uint64_t Failures;          // Site failures represented by this record
+    uint32_t ThreadId;
+    uint32_t LineNumber;
+    uint32_t AuxCode;
+    char FileName[SOFT_ASSERT_FILE_LEN];
+    INTEGER_TYPE CallStack[CALL_STACK_SIZE];
+};
+
+/// Soft assertion statistics
+struct SoftAssertStats
+{
+    uint64_t Recorded;          // Records written to the ring buffer
+    uint64_t Throttled;         // Records refused by the global token bucket
+};
+
+/// Handle a failed soft assertion. Called by ASSERT_SOFT(); returns to the
+/// caller. Thread safe and lock-free; not async-signal-safe.
+/// @param[in] site - the call site state
+/// @param[in] file - the file name that the assertion failed in
+/// @param[in] line - the line number that the assertion failed on
+/// @param[in] auxCode - any additional number, or 0
+void SoftAssertFail(SoftAssertSite* site, const char* file, unsigned short line, uint32_t auxCode);
+
+/// Get the ring position of the next record to be written. Records from
+/// SoftAssertNext() - SOFT_ASSERT_RING_SIZE onwards are readable.
+/// @return The number of records written since startup.
+uint64_t SoftAssertNext();
+
+/// Copy a record out of the ring buffer.
+/// @param[in] sequence - the ring position to read
+/// @param[out] record - the record copy
+/// @return True if read; false if the record is overwritten or not yet complete.
+bool SoftAssertRead(uint64_t sequence, SoftAssertRecord* record);
+
+/// Get the soft assertion statistics
+SoftAssertStats SoftAssertGetStats();
+
+#endif
@@ -0,0 +1,122 @@
+#include "StackBounds.h"
+#include "SlotRegistry.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+/// A registered stack address range
+struct ThreadStack
+{
+    std::atomic<int> State;
+    uintptr_t Low;
+    uintptr_t High;
+};
+
+static ThreadStack _stacks[MAX_THREAD_STACKS];
+
+#if defined(__linux__) || defined(_WIN32)
+// Registration id of the calling thread stack
+static thread_local int _threadStackId = -1;
+#endif
+
+int StackBoundsRegister(const void* low, const void* high)
+{
+    if (low == NULL || (uintptr_t)high <= (uintptr_t)low)
+        return -1;
+
+    for (int id = 0; id < MAX_THREAD_STACKS; id++)
+    {
+        if (!SlotClaim(&_stacks[id].State))
+            continue;
+
+        _stacks[id].Low = (uintptr_t)low;
+        _stacks[id].High = (uintptr_t)high;
+        SlotPublish(&_stacks[id].State);
+        return id;
+    }
+
+    // All slots in use. Increase MAX_THREAD_STACKS.
+    return -1;
+}
+
+void StackBoundsUnregister(int id)
+{
+    if (id < 0 || id >= MAX_THREAD_STACKS)
+        return;
+    SlotRelease(&_stacks[id].State);
+}
+
+int StackBoundsRegisterThread()
+{
+#if defined(__linux__)
+    if (_threadStackId >= 0)
+        return _threadStackId;
+
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0)
+        return -1;
+
+    // The returned range excludes the guard page. For the main thread it
+    // spans the stack size limit, of which only the grown part is mapped.
+    void* low = NULL;
+    size_t size = 0;
+    int err = pthread_attr_getstack(&attr, &low, &size);
+    pthread_attr_destroy(&attr);
+    if (err != 0)
+        return -1;
+
+    _threadStackId = StackBoundsRegister(low, (const uint8_t*)low + size);
+    return _threadStackId;
+#elif defined(_WIN32)
+    if (_threadStackId >= 0)
+        return _threadStackId;
+
+    ULONG_PTR low = 0, high = 0;
+    GetCurrentThreadStackLimits(&low, &high);
+    _threadStackId = StackBoundsRegister((const void*)low, (const void*)high);
+    return _threadStackId;
+#else
+    // TODO: Register each task stack using StackBoundsRegister() on task creation
+    return -1;
+#endif
+}
+
+void StackBoundsUnregisterThread()
+{
+#if defined(__linux__) || defined(_WIN32)
+    StackBoundsUnregister(_threadStackId);
+    _threadStackId = -1;
+#endif
+}
+
+bool StackBoundsFind(const void* address, uintptr_t* low, uintptr_t* high)
+{
+    uintptr_t addr = (uintptr_t)address;
+    for (int id = 0; id < MAX_THREAD_STACKS; id++)
+    {
+        const ThreadStack* stack = &_stacks[id];
+        if (!SlotActive(&stack->State))
+            continue;
+
+        if (addr >= stack->Low && addr < stack->High)
+        {
+            *low = stack->Low;
+            *high = stack->High;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t StackBoundsClamp(const void* address, uint32_t length)
+{
+    uintptr_t low, high;
+    if (!StackBoundsFind(address, &low, &high))
+        return length;
+
+    uintptr_t available = high - (uintptr_t)address;
+    return available < length ? (uint32_t)available : length;
+}
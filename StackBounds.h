@@ -0,0 +1,47 @@
+#ifndef _STACK_BOUNDS_H
+#define _STACK_BOUNDS_H
+
+// Per-thread stack bounds registry. Each thread stack is registered with its
+// exact [low, high) address range when the thread starts, so the call stack
+// search and the stack copies stored within the core dump stop at the real
+// stack base instead of running into neighbouring memory. Lookup by stack
+// pointer is lock-free and async-signal-safe.
+
+#include "CoreDump.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/// Register a stack address range. On an RTOS call when a task is created
+/// using the stack fields of the task control block.
+/// @param[in] low - the lowest stack address (the stack limit)
+/// @param[in] high - one past the highest stack address (the stack base)
+/// @return A registration id, or -1 if MAX_THREAD_STACKS are registered.
+int StackBoundsRegister(const void* low, const void* high);
+
+/// Unregister a stack before it is freed.
+/// @param[in] id - the registration id
+void StackBoundsUnregister(int id);
+
+/// Register the calling thread stack. Call once at thread start. The bounds
+/// are obtained using pthread_getattr_np() on Linux and
+/// GetCurrentThreadStackLimits() on Windows.
+/// @return A registration id, or -1 if not registered.
+int StackBoundsRegisterThread();
+
+/// Unregister the calling thread stack. Call before the thread exits.
+void StackBoundsUnregisterThread();
+
+/// Find the registered stack holding an address. Async-signal-safe.
+/// @param[in] address - an address within the stack, e.g. the stack pointer
+/// @param[out] low - the lowest stack address
+/// @param[out] high - one past the highest stack address
+/// @return True if found; false if the address is not within a registered stack.
+bool StackBoundsFind(const void* address, uintptr_t* low, uintptr_t* high);
+
+/// Limit a copy starting within a registered stack to the stack base.
+/// @param[in] address - the copy start address
+/// @param[in] length - the copy length in bytes
+/// @return The clamped length, or length if address is not within a registered stack.
+uint32_t StackBoundsClamp(const void* address, uint32_t length);
+
+#endif
@@ -0,0 +1,143 @@
+#include "StackCapture.h"
+
+#ifdef __linux__
+
+#ifdef USE_SHADOW_STACK
+#include "ShadowStack.h"
+#endif
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// Maximum backtrace() frames for the signal handlers and the signal return
+// trampoline, above the interrupted frame
+#define HANDLER_FRAMES      4
+
+// Get the interrupted instruction address from the signal context
+static INTEGER_TYPE ContextPc(void* userContext)
+{
+#if defined(__x86_64__)
+    return (INTEGER_TYPE)((ucontext_t*)userContext)->uc_mcontext.gregs[REG_RIP];
+#elif defined(__aarch64__)
+    return (INTEGER_TYPE)((ucontext_t*)userContext)->uc_mcontext.pc;
+#else
+    (void)userContext;
+    return 0;
+#endif
+}
+
+void StackCaptureInit()
+{
+    void* warmUp[1];
+    backtrace(warmUp, 1);
+}
+
+uint32_t StackCaptureSignal(void* userContext, INTEGER_TYPE* callStack, int maxCnt)
+{
+    if (maxCnt > STACK_CAPTURE_MAX_DEPTH)
+        maxCnt = STACK_CAPTURE_MAX_DEPTH;
+    if (maxCnt <= 0)
+        return 0;
+
+    INTEGER_TYPE pc = ContextPc(userContext);
+
+#ifdef USE_SHADOW_STACK
+    // The interrupted instruction, then the active instrumented functions
+    if (pc != 0 && ShadowStackDepth() != 0)
+    {
+        callStack[0] = pc;
+        return 1 + ShadowStackCopy(callStack + 1, maxCnt - 1);
+    }
+#endif
+
+    void* frames[STACK_CAPTURE_MAX_DEPTH + HANDLER_FRAMES];
+    int cnt = backtrace(frames, maxCnt + HANDLER_FRAMES);
+
+    // Skip this function, the handler and the trampoline; the interrupted 
+    // frame holds the context PC
+    int first = 0;
+    while (first < cnt && first < HANDLER_FRAMES && (INTEGER_TYPE)frames[first] != pc)
+        first++;
+    if (first == HANDLER_FRAMES || first == cnt)
+        first = cnt > 3 ? 3 : cnt;
+
+    uint32_t depth = 0;
+    for (int f = first; f < cnt && depth < (uint32_t)maxCnt; f++)
+        callStack[depth++] = (INTEGER_TYPE)frames[f];
+    return depth;
+}
+
+uint32_t StackCaptureSignalAll(int signalNumber, int skipThreadId)
+{
+    uint32_t sent = 0;
+    pid_t pid = getpid();
+    DIR* tasks = opendir("/proc/self/task");
+    if (tasks == NULL)
+        return 0;
+
+    struct dirent* entry;
+    while ((entry = readdir(tasks)) != NULL)
+    {
+        pid_t threadId = (pid_t)atoi(entry->d_name);
+        if (threadId <= 0 || threadId == skipThreadId)
+            continue;
+        if (syscall(SYS_tgkill, pid, threadId, signalNumber) == 0)
+            sent++;
+    }
+    closedir(tasks);
+    return sent;
+}
+
+std::string StackCaptureSymbolName(INTEGER_TYPE address)
+{
+    Dl_info info;
+    if (dladdr((void*)address, &info) != 0)
+    {
+        if (info.dli_sname != NULL)
+        {
+            int status = -1;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+            std::string name = status == 0 ? demangled : info.dli_sname;
+            free(demangled);
+            return name;
+        }
+        if (info.dli_fname != NULL)
+        {
+            const char* file = strrchr(info.dli_fname, '/');
+            char offset[32];
+            snprintf(offset, sizeof(offset), "+0x%llx",
+                (unsigned long long)(address - (INTEGER_TYPE)info.dli_fbase));
+            return std::string(file != NULL ? file + 1 : info.dli_fname) + offset;
+        }
+    }
+
+    char text[32];
+    snprintf(text, sizeof(text), "0x%llx", (unsigned long long)address);
+    return text;
+}
+
+std::string StackCaptureFolded(const INTEGER_TYPE* callStack, uint32_t depth,
+    std::unordered_map<INTEGER_TYPE, std::string>* symbols)
+{
+    std::string line;
+    for (uint32_t f = depth; f-- > 0;)
+    {
+        INTEGER_TYPE address = f == 0 ? callStack[f] : callStack[f] - 1;
+        auto symbol = symbols->find(address);
+        if (symbol == symbols->end())
+            symbol = symbols->emplace(address, StackCaptureSymbolName(address)).first;
+        if (!line.empty())
+            line += ';';
+        line += symbol->second;
+    }
+    return line;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef _STACK_CAPTURE_H
+#define _STACK_CAPTURE_H
+
+// Call stack capture from within a signal handler, shared by the sampling
+// profilers and the live snapshot. Uses the shadow stack (USE_SHADOW_STACK)
+// if an instrumented function is active on the interrupted thread;
+// otherwise backtrace(), skipping the signal handler frames.
+//
+// Also sends a capture signal to every thread of the process, and formats
+// captured call stacks in the folded stack format read by flamegraph.pl.
+
+#include "CoreDump.h"
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+#ifdef __linux__
+
+// Maximum call stack depth captured
+#define STACK_CAPTURE_MAX_DEPTH     64
+
+/// Prepare backtrace() for use within signal handlers. The first call loads
+/// libgcc, which is not async-signal-safe. Call before installing a handler.
+void StackCaptureInit();
+
+/// Capture the call stack interrupted by a signal, innermost frame first.
+/// Async-signal-safe after StackCaptureInit().
+/// @param[in] userContext - the signal handler ucontext_t argument
+/// @param[out] callStack - the destination array
+/// @param[in] maxCnt - the destination array length, up to STACK_CAPTURE_MAX_DEPTH
+/// @return The number of frames stored.
+uint32_t StackCaptureSignal(void* userContext, INTEGER_TYPE* callStack, int maxCnt);
+
+/// Send a signal to every thread of the process using tgkill(). Threads
+/// started during the call may not be signaled.
+/// @param[in] signalNumber - the signal
+/// @param[in] skipThreadId - a thread ID not to signal, or 0
+/// @return The number of threads signaled.
+uint32_t StackCaptureSignalAll(int signalNumber, int skipThreadId);
+
+/// Get a symbol name for a code address using dladdr(). Link with -rdynamic
+/// to name the functions of the executable. Not async-signal-safe.
+/// @param[in] address - the code address
+/// @return The demangled symbol, module+offset, or the hex address.
+std::string StackCaptureSymbolName(INTEGER_TYPE address);
+
+/// Format a call stack as a folded stack line, root first, without the
+/// count. Return addresses are looked up at the call instruction.
+/// @param[in] callStack - the call stack, innermost frame first
+/// @param[in] depth - the number of frames
+/// @param[in,out] symbols - symbol names cached across calls
+/// @return The frame names separated by ';'.
+std::string StackCaptureFolded(const INTEGER_TYPE* callStack, uint32_t depth,
+    std::unordered_map<INTEGER_TYPE, std::string>* symbols);
+
+#endif
+#endif
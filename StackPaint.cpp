@@ -0,0 +1,202 @@
+#include "StackPaint.h"
+#include "SlotRegistry.h"
+#include <cstring>
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define USE_STACK_SCAN_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define USE_STACK_SCAN_NEON
+#endif
+
+// Bytes compared per SIMD loop iteration
+#define SCAN_BLOCK      64
+
+/// A registered stack
+struct PaintedStack
+{
+    std::atomic<int> State;
+    char Name[REGION_NAME_LEN];
+    uint8_t* Base;
+    size_t Size;
+};
+
+static PaintedStack _stacks[MAX_PAINTED_STACKS];
+
+#if defined(__linux__)
+// Registration id of the calling thread stack
+static thread_local int _threadStackId = -1;
+#endif
+
+size_t StackPaintScan(const void* base, size_t size)
+{
+    const uint8_t* begin = (const uint8_t*)base;
+    const uint8_t* end = begin + size;
+    const uint8_t* p = begin;
+
+    // Bytes up to the first aligned block
+    while (p < end && ((uintptr_t)p & (SCAN_BLOCK - 1)) != 0 && *p == STACK_PAINT_BYTE)
+        p++;
+
+    // Skip whole painted blocks. Stops at the first block holding a
+    // used byte; the byte loop below finds it.
+    if (((uintptr_t)p & (SCAN_BLOCK - 1)) == 0)
+    {
+#if defined(USE_STACK_SCAN_SSE2)
+        const __m128i marker = _mm_set1_epi8((char)STACK_PAINT_BYTE);
+        while (end - p >= SCAN_BLOCK)
+        {
+            __m128i eq0 = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)p), marker);
+            __m128i eq1 = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)(p + 16)), marker);
+            __m128i eq2 = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)(p + 32)), marker);
+            __m128i eq3 = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)(p + 48)), marker);
+            __m128i eq = _mm_and_si128(_mm_and_si128(eq0, eq1), _mm_and_si128(eq2, eq3));
+            if (_mm_movemask_epi8(eq) != 0xFFFF)
+                break;
+            p += SCAN_BLOCK;
+        }
+#elif defined(USE_STACK_SCAN_NEON)
+        const uint8x16_t marker = vdupq_n_u8(STACK_PAINT_BYTE);
+        while (end - p >= SCAN_BLOCK)
+        {
+            uint8x16_t eq0 = vceqq_u8(vld1q_u8(p), marker);
+            uint8x16_t eq1 = vceqq_u8(vld1q_u8(p + 16), marker);
+            uint8x16_t eq2 = vceqq_u8(vld1q_u8(p + 32), marker);
+            uint8x16_t eq3 = vceqq_u8(vld1q_u8(p + 48), marker);
+            uint8x16_t eq = vandq_u8(vandq_u8(eq0, eq1), vandq_u8(eq2, eq3));
+            if (vminvq_u8(eq) != 0xFF)
+                break;
+            p += SCAN_BLOCK;
+        }
+#else
+        while (end - p >= (ptrdiff_t)sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, p, sizeof(word));
+            if (word != 0x0101010101010101ull * STACK_PAINT_BYTE)
+                break;
+            p += sizeof(word);
+        }
+#endif
+    }
+
+    while (p < end && *p == STACK_PAINT_BYTE)
+        p++;
+
+    // A partly overwritten word was used
+    return (size_t)(p - begin) & ~(sizeof(INTEGER_TYPE) - 1);
+}
+
+int StackPaintRegister(const char* name, void* base, size_t size)
+{
+    if (name == NULL || base == NULL || size == 0)
+        return -1;
+
+    for (int id = 0; id < MAX_PAINTED_STACKS; id++)
+    {
+        if (!SlotClaim(&_stacks[id].State))
+            continue;
+
+        PaintedStack* stack = &_stacks[id];
+        strncpy(stack->Name, name, REGION_NAME_LEN);
+        stack->Name[REGION_NAME_LEN - 1] = 0;
+        stack->Base = (uint8_t*)base;
+        stack->Size = size;
+
+        // The calling thread's own stack is painted only below the current
+        // frame; the frames above are in use
+        uint8_t* paintEnd = stack->Base + size;
+        uint8_t* frame = (uint8_t*)&paintEnd;
+        if (frame >= stack->Base && frame < paintEnd)
+            paintEnd = frame - stack->Base > STACK_PAINT_MARGIN ? frame - STACK_PAINT_MARGIN : stack->Base;
+        memset(stack->Base, STACK_PAINT_BYTE, paintEnd - stack->Base);
+
+        SlotPublish(&stack->State);
+        return id;
+    }
+
+    // All slots in use. Increase MAX_PAINTED_STACKS.
+    return -1;
+}
+
+void StackPaintUnregister(int id)
+{
+    if (id < 0 || id >= MAX_PAINTED_STACKS)
+        return;
+    SlotRelease(&_stacks[id].State);
+}
+
+int StackPaintRegisterThread(const char* name, size_t maxSize)
+{
+#if defined(__linux__)
+    if (_threadStackId >= 0)
+        return _threadStackId;
+
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0)
+        return -1;
+
+    void* low = NULL;
+    size_t size = 0;
+    int err = pthread_attr_getstack(&attr, &low, &size);
+    pthread_attr_destroy(&attr);
+    if (err != 0)
+        return -1;
+
+    // Keep the top of the stack; it grows down from the base
+    uint8_t* base = (uint8_t*)low;
+    if (size > maxSize)
+    {
+        base += size - maxSize;
+        size = maxSize;
+    }
+    _threadStackId = StackPaintRegister(name, base, size);
+    return _threadStackId;
+#else
+    // TODO: Paint each task stack using StackPaintRegister() on task creation.
+    // On Windows, painting the uncommitted pages below the stack guard page faults.
+    (void)name;
+    (void)maxSize;
+    return -1;
+#endif
+}
+
+void StackPaintUnregisterThread()
+{
+#if defined(__linux__)
+    StackPaintUnregister(_threadStackId);
+    _threadStackId = -1;
+#endif
+}
+
+bool StackPaintGetUsage(int id, CoreDumpStackUsage* usage)
+{
+    if (id < 0 || id >= MAX_PAINTED_STACKS)
+        return false;
+
+    const PaintedStack* stack = &_stacks[id];
+    if (!SlotActive(&stack->State))
+        return false;
+
+    memcpy(usage->Name, stack->Name, REGION_NAME_LEN);
+    usage->Base = (uint64_t)(uintptr_t)stack->Base;
+    usage->Size = (uint32_t)stack->Size;
+    usage->Peak = (uint32_t)(stack->Size - StackPaintScan(stack->Base, stack->Size));
+    return true;
+}
+
+uint32_t StackPaintGetAllUsage(CoreDumpStackUsage* usage, uint32_t maxCnt)
+{
+    uint32_t cnt = 0;
+    for (int id = 0; id < MAX_PAINTED_STACKS && cnt < maxCnt; id++)
+    {
+        if (StackPaintGetUsage(id, &usage[cnt]))
+            cnt++;
+    }
+    return cnt;
+}
@@ -0,0 +1,69 @@
+#ifndef _STACK_PAINT_H
+#define _STACK_PAINT_H
+
+// Stack high-water-mark measurement. A registered stack is painted with the 
+// STACK_MARKER byte pattern. Stacks grow down, so the painted bytes remaining 
+// at the low end of the stack were never used; a SIMD scan from the stack 
+// limit up to the first overwritten word gives the peak stack usage. Each 
+// core dump records the peak usage of every registered stack.
+
+#include "CoreDump.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Painted byte value. Each byte of STACK_MARKER.
+#define STACK_PAINT_BYTE        0xEF
+
+// Bytes below the current stack pointer left unpainted when a thread paints
+// its own stack. Covers the painting function frames and the red zone.
+#define STACK_PAINT_MARGIN      4096
+
+// Bytes of the main thread stack registered by StackPaintRegisterThread().
+// The main thread stack spans the stack size limit, mostly never used.
+#define STACK_PAINT_MAIN_SIZE   (256 * 1024)
+
+/// Paint a stack and register it for peak usage measurement. Call when a 
+/// stack is created, before the thread runs; or from the thread itself, in 
+/// which case only the stack below the current frame is painted. Painting 
+/// touches, and so commits, every page of the stack. 
+/// @param[in] name - a short stack name (truncated to REGION_NAME_LEN - 1)
+/// @param[in] base - the lowest stack address (the stack limit)
+/// @param[in] size - the stack size in bytes
+/// @return A registration id, or -1 if MAX_PAINTED_STACKS are registered.
+int StackPaintRegister(const char* name, void* base, size_t size);
+
+/// Unregister a stack before it is freed.
+/// @param[in] id - the registration id
+void StackPaintUnregister(int id);
+
+/// Paint and register the calling thread stack. Call once at thread start.
+/// The bounds are obtained using pthread_getattr_np() on Linux.
+/// @param[in] name - a short stack name
+/// @param[in] maxSize - the maximum bytes registered, measured down from 
+///     the stack base, e.g. STACK_PAINT_MAIN_SIZE for the main thread
+/// @return A registration id, or -1 if not registered.
+int StackPaintRegisterThread(const char* name, size_t maxSize);
+
+/// Unregister the calling thread stack. Call before the thread exits.
+void StackPaintUnregisterThread();
+
+/// Get the peak usage of a registered stack. Scans the stack; takes 
+/// microseconds for a MB sized stack.
+/// @param[in] id - the registration id
+/// @param[out] usage - the stack usage
+/// @return True if the id is registered.
+bool StackPaintGetUsage(int id, CoreDumpStackUsage* usage);
+
+/// Get the peak usage of all registered stacks. Async-signal-safe.
+/// @param[out] usage - the stack usage array
+/// @param[in] maxCnt - the usage array length
+/// @return The number of stacks stored.
+uint32_t StackPaintGetAllUsage(CoreDumpStackUsage* usage, uint32_t maxCnt);
+
+/// Count the painted bytes at the low end of a stack. 
+/// @param[in] base - the lowest stack address
+/// @param[in] size - the stack size in bytes
+/// @return The number of never used bytes, a multiple of the word size.
+size_t StackPaintScan(const void* base, size_t size);
+
+#endif
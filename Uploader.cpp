@@ -0,0 +1,320 @@
+#include "Uploader.h"
+
+#ifdef __linux__
+
+#include "CollectorClient.h"
+#include "Compress.h"
+#include "Crc32c.h"
+#include "DumpStore.h"
+#include "Fault.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#define CURSOR_MAGIC        0x52535543      // "CUSR"
+
+// Retry delays while the collector is busy or absent
+#define RETRY_MIN_MS        100
+#define RETRY_MAX_MS        (30 * 1000)
+
+// Idle poll interval when the store is fully uploaded
+#define IDLE_POLL_MS        (5 * 1000)
+
+// I/O priority (see ioprio_set(2))
+#define IOPRIO_WHO_PROCESS  1
+#define IOPRIO_CLASS_IDLE   3
+#define IOPRIO_CLASS_SHIFT  13
+
+/// Persisted upload position
+struct UploadCursor
+{
+    uint32_t Magic;
+    uint32_t Crc;           // CRC32C of the cursor computed with Crc = 0
+    uint64_t Offset;        // Store offset of the next record to upload
+};
+
+static UploaderConfig _config;
+static std::thread _thread;
+static std::mutex _lock;
+static std::condition_variable _wake;
+static bool _stop = false;
+
+// Submitted core dump waiting to be persisted. Kept until a commit
+// succeeds. _pendingNew wakes the uploader thread.
+static CoreDumpData _pending;
+static bool _pendingValid = false;
+
+// The submitted core dump is stored as a compressed stream and uploaded 
+// as stored
+static CompressState _compressState;
+static uint8_t _compressed[COMPRESS_STREAM_BOUND(sizeof(CoreDumpData))];
+static bool _pendingNew = false;
+
+// The owner of the submitted copy, reset or released once persisted: a
+// fast boot slot index, PENDING_OWNER_SAVED for the saved core dump or
+// PENDING_OWNER_NONE
+#define PENDING_OWNER_NONE  -1
+#define PENDING_OWNER_SAVED -2
+static int _pendingOwner = PENDING_OWNER_NONE;
+
+static std::atomic<uint64_t> _persisted(0);
+static std::atomic<uint64_t> _uploaded(0);
+static std::atomic<uint64_t> _skipped(0);
+static std::atomic<uint64_t> _retries(0);
+
+static uint32_t CursorCrc(UploadCursor cursor)
+{
+    cursor.Crc = 0;
+    return Crc32c(0, &cursor, sizeof(cursor));
+}
+
+static uint64_t LoadCursor()
+{
+    UploadCursor cursor;
+    uint64_t offset = 0;
+    int fd = open(_config.CursorPath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+
+    // A torn cursor restarts from the beginning; the collector deduplicates
+    if (read(fd, &cursor, sizeof(cursor)) == (ssize_t)sizeof(cursor) &&
+        cursor.Magic == CURSOR_MAGIC && cursor.Crc == CursorCrc(cursor))
+        offset = cursor.Offset;
+    close(fd);
+    return offset;
+}
+
+static void SaveCursor(int fd, uint64_t offset)
+{
+    UploadCursor cursor;
+    cursor.Magic = CURSOR_MAGIC;
+    cursor.Offset = offset;
+    cursor.Crc = CursorCrc(cursor);
+    if (pwrite(fd, &cursor, sizeof(cursor), 0) == (ssize_t)sizeof(cursor))
+        fdatasync(fd);
+}
+
+// Wait until woken or timed out. Returns false if stopping.
+static bool Sleep(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    _wake.wait_for(lock, timeout, [] { return _stop || _pendingNew; });
+    _pendingNew = false;
+    return !_stop;
+}
+
+// Persist a submitted core dump, if any. On failure the submission is kept
+// and retried on the next call.
+static void PersistPending(DumpStore* store)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    if (!_pendingValid)
+        return;
+    size_t length = CompressBuffer(&_compressState, &_pending, sizeof(_pending), 
+        _compressed, sizeof(_compressed));
+    if (length == 0 || !store->Append(_compressed, (uint32_t)length, DumpStackHash(&_pending), 
+        DUMP_RECORD_COMPRESSED) || !store->Commit())
+        return;
+
+    _persisted++;
+    _pendingValid = false;
+
+    // Durable; the saved core dump is no longer needed
+#ifdef USE_FAST_BOOT
+    if (_pendingOwner >= 0)
+        CoreDumpSlotRelease((uint32_t)_pendingOwner);
+#endif
+    if (_pendingOwner == PENDING_OWNER_SAVED)
+        CoreDumpReset();
+    _pendingOwner = PENDING_OWNER_NONE;
+}
+
+/// Token bucket rate limiter
+class TokenBucket
+{
+public:
+    TokenBucket(uint32_t rate, uint32_t burst) :
+        m_rate(rate), m_burst(burst), m_tokens(burst), m_last(std::chrono::steady_clock::now())
+    {
+    }
+
+    /// Take tokens for a send. A send larger than the bucket depth waits for
+    /// a full bucket and leaves a debt.
+    /// @return The time to wait before the send may proceed.
+    std::chrono::milliseconds Take(uint32_t bytes)
+    {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - m_last).count();
+        m_last = now;
+        m_tokens = std::min((double)m_burst, m_tokens + elapsed * m_rate);
+
+        double needed = std::min((double)bytes, (double)m_burst);
+        if (m_tokens < needed)
+            return std::chrono::milliseconds((int64_t)((needed - m_tokens) * 1000 / m_rate) + 1);
+
+        m_tokens -= bytes;
+        return std::chrono::milliseconds(0);
+    }
+
+private:
+    double m_rate;
+    double m_burst;
+    double m_tokens;
+    std::chrono::steady_clock::time_point m_last;
+};
+
+static void UploaderThread()
+{
+#ifdef USE_LINUX_SIGNALS
+    SignalFaultThread signalFaultThread;
+#endif
+    // Lowest CPU and I/O priority. Production work always runs first.
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    sched_setscheduler(0, SCHED_IDLE, &param);
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+
+    // Retry until the store opens; a submitted core dump waits meanwhile
+    static DumpStore store;
+    uint32_t retryMs = RETRY_MIN_MS;
+    while (!store.Open(_config.StorePath))
+    {
+        if (!Sleep(std::chrono::milliseconds(retryMs)))
+            return;
+        retryMs = std::min(retryMs * 2, (uint32_t)RETRY_MAX_MS);
+    }
+    PersistPending(&store);
+
+    int cursorFd = open(_config.CursorPath, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    uint64_t offset = LoadCursor();
+    if (offset > store.Size())
+        offset = 0;
+
+    // A stored record is either a compressed stream or, from earlier 
+    // versions, a raw core dump. The collector accepts both.
+    static uint8_t record[COMPRESS_STREAM_BOUND(sizeof(CoreDumpData))];
+    TokenBucket bucket(_config.RateBytes, _config.BurstBytes);
+    retryMs = RETRY_MIN_MS;
+
+    for (;;)
+    {
+        DumpRecordHeader header;
+        uint64_t next;
+        DumpReadResult result = store.Read(offset, &header, record, sizeof(record), &next);
+        if (result == DUMP_READ_END)
+        {
+            // Everything is uploaded; wait for a new submission
+            if (!Sleep(std::chrono::milliseconds(IDLE_POLL_MS)))
+                break;
+            PersistPending(&store);
+            continue;
+        }
+
+        // Duplicates carry no payload; the collector already has the stack.
+        // A record larger than a core dump is not one; skip it.
+        if (!(header.Flags & DUMP_RECORD_DUPLICATE) && result == DUMP_READ_OK)
+        {
+            std::chrono::milliseconds wait = bucket.Take(header.Length);
+            if (wait.count() != 0)
+            {
+                if (!Sleep(wait))
+                    break;
+                PersistPending(&store);
+                continue;
+            }
+
+            if (!CollectorSend(_config.SocketPath, record, header.Length))
+            {
+                // Back off while the collector is busy or absent
+                _retries++;
+                if (!Sleep(std::chrono::milliseconds(retryMs)))
+                    break;
+                retryMs = std::min(retryMs * 2, (uint32_t)RETRY_MAX_MS);
+                PersistPending(&store);
+                continue;
+            }
+            retryMs = RETRY_MIN_MS;
+            _uploaded++;
+        }
+        else
+        {
+            _skipped++;
+        }
+
+        offset = next;
+        if (cursorFd >= 0)
+            SaveCursor(cursorFd, offset);
+        PersistPending(&store);
+    }
+
+    if (cursorFd >= 0)
+        close(cursorFd);
+    store.Close();
+}
+
+bool UploaderStart(const UploaderConfig* config)
+{
+    if (_thread.joinable() || config->RateBytes == 0)
+        return false;
+
+    _config = *config;
+    _stop = false;
+    _thread = std::thread(UploaderThread);
+    return true;
+}
+
+void UploaderStop()
+{
+    if (!_thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _stop = true;
+    }
+    _wake.notify_all();
+    _thread.join();
+}
+
+bool UploaderSubmit(const CoreDumpData* coreDumpData)
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (_pendingValid)
+            return false;
+        memcpy(&_pending, coreDumpData, sizeof(_pending));
+        _pendingValid = true;
+        _pendingNew = true;
+        _pendingOwner = PENDING_OWNER_NONE;
+#ifdef USE_FAST_BOOT
+        for (uint32_t slot = 0; slot < CORE_DUMP_SLOT_CNT; slot++)
+        {
+            if (coreDumpData == CoreDumpSlotGet(slot))
+                _pendingOwner = (int)slot;
+        }
+#endif
+        if (_pendingOwner == PENDING_OWNER_NONE && coreDumpData == CoreDumpGet())
+            _pendingOwner = PENDING_OWNER_SAVED;
+    }
+    _wake.notify_all();
+    return true;
+}
+
+UploaderStats UploaderGetStats()
+{
+    UploaderStats stats;
+    stats.Persisted = _persisted;
+    stats.Uploaded = _uploaded;
+    stats.Skipped = _skipped;
+    stats.Retries = _retries;
+    return stats;
+}
+
+#endif
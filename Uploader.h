@@ -0,0 +1,62 @@
+#ifndef _UPLOADER_H
+#define _UPLOADER_H
+
+// Background core dump uploader. A low priority thread persists submitted
+// core dumps, compressed (Compress.h), into a DumpStore and drains the store
+// to the local collector (Collector/) at a token bucket rate limit. The 
+// upload position is saved in a cursor file so an interrupted upload resumes
+// after a reboot. Opening and scanning the store happens on the uploader 
+// thread; startup time does not depend on the number of queued dumps.
+
+#include "CoreDump.h"
+#include <stdint.h>
+
+#ifdef __linux__
+
+// Default upload rate limit
+#define UPLOADER_RATE_BYTES     (64 * 1024)
+#define UPLOADER_BURST_BYTES    (256 * 1024)
+
+/// Uploader configuration
+struct UploaderConfig
+{
+    const char* StorePath;      // Dump store file
+    const char* CursorPath;     // Upload position file
+    const char* SocketPath;     // Collector socket, e.g. COLLECTOR_SOCKET_PATH
+    uint32_t RateBytes;         // Token bucket fill rate in bytes per second
+    uint32_t BurstBytes;        // Token bucket depth in bytes
+};
+
+/// Uploader statistics
+struct UploaderStats
+{
+    uint64_t Persisted;         // Submitted core dumps written to the store
+    uint64_t Uploaded;          // Records accepted by the collector
+    uint64_t Skipped;           // Duplicate and oversized records not uploaded
+    uint64_t Retries;           // Sends refused by a busy or absent collector
+};
+
+/// Start the uploader thread. Returns immediately.
+/// @param[in] config - the uploader configuration. Strings must remain valid
+///     until UploaderStop().
+/// @return True if the thread started.
+bool UploaderStart(const UploaderConfig* config);
+
+/// Stop the uploader thread. Uploads resume from the saved cursor on the
+/// next UploaderStart().
+void UploaderStop();
+
+/// Queue a copy of a core dump to persist and upload. Returns immediately.
+/// The copy is kept until written to the store. If coreDumpData is the saved
+/// core dump (CoreDumpGet()) or a fast boot slot (CoreDumpSlotGet()), the
+/// uploader thread calls CoreDumpReset() or CoreDumpSlotRelease() once the
+/// copy is durable, so a crash before then keeps the saved core dump.
+/// @param[in] coreDumpData - the core dump to copy
+/// @return True if queued; false if a previous submission is still pending.
+bool UploaderSubmit(const CoreDumpData* coreDumpData);
+
+/// Get the uploader statistics
+UploaderStats UploaderGetStats();
+
+#endif
+#endif
@@ -0,0 +1,317 @@
+#include "WallProfiler.h"
+
+#ifdef __linux__
+
+#include "Fault.h"
+#include "StackCapture.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// Signal each thread handles to capture its own call stack. Not a real-time
+// signal; a thread blocking it for a long time has one signal pending rather
+// than one queued per interval. Ignored by default, so a signal arriving
+// after WallProfilerStop() is harmless.
+#define WALL_PROFILER_SIGNAL    SIGURG
+
+// FNV-1a 64-bit
+#define FNV_OFFSET  0xcbf29ce484222325ull
+#define FNV_PRIME   0x100000001b3ull
+
+/// One thread call stack captured within an interval, innermost frame first
+struct WallSample
+{
+    uint32_t ThreadId;          // Published last; 0 if the capture did not complete
+    uint32_t Depth;
+    uint32_t Repeat;            // Identical to the thread's previous sample
+    INTEGER_TYPE Frames[WALL_PROFILER_STACK_DEPTH];
+};
+
+/// A thread seen by the sampler
+struct WallThread
+{
+    std::string Name;
+    uint64_t Round;             // The last round the thread was aggregated
+    uint64_t* Count;            // The aggregated count of the thread's last sample
+};
+
+static WallSample _samples[WALL_PROFILER_MAX_THREADS];
+
+// The previous sample stack hash of each thread
+static thread_local uint64_t _lastHash __attribute__((tls_model("initial-exec"))) = 0;
+
+// Capture in progress. A thread claims a _samples entry before checking
+// _collecting, so once _collecting is cleared every claimed entry is counted
+// in _claimed and no new entry is written.
+static std::atomic<bool> _collecting(false);
+static std::atomic<uint32_t> _claimed(0);
+static std::atomic<uint32_t> _done(0);
+
+static WallProfilerConfig _config;
+static struct sigaction _previousAction;
+static int _samplerThreadId = 0;
+
+static std::thread _sampler;
+static std::mutex _lock;
+static std::condition_variable _wake;
+static bool _stop = false;
+
+// Aggregated call stacks by thread name, innermost frame first. Guarded by
+// _lock, as are the threads and statistics.
+static std::map<std::pair<std::string, std::vector<INTEGER_TYPE>>, uint64_t> _stacks;
+static std::unordered_map<uint32_t, WallThread> _threads;
+static WallProfilerStats _stats;
+
+static uint64_t StackHash(const INTEGER_TYPE* frames, uint32_t depth)
+{
+    uint64_t hash = FNV_OFFSET;
+    const uint8_t* bytes = (const uint8_t*)frames;
+    for (size_t b = 0; b < depth * sizeof(INTEGER_TYPE); b++)
+        hash = (hash ^ bytes[b]) * FNV_PRIME;
+    return hash;
+}
+
+static void CaptureSignalHandler(int signalNumber, siginfo_t* signalInfo, void* userContext)
+{
+    (void)signalNumber;
+    (void)signalInfo;
+    int savedErrno = errno;
+
+    uint32_t idx = _claimed.fetch_add(1);
+    if (_collecting.load() && idx < WALL_PROFILER_MAX_THREADS)
+    {
+        WallSample* sample = &_samples[idx];
+        sample->Depth = StackCaptureSignal(userContext, sample->Frames, WALL_PROFILER_STACK_DEPTH);
+        uint64_t hash = StackHash(sample->Frames, sample->Depth);
+        sample->Repeat = hash == _lastHash;
+        _lastHash = hash;
+        __atomic_store_n(&sample->ThreadId, (uint32_t)syscall(SYS_gettid), __ATOMIC_RELEASE);
+    }
+    _done.fetch_add(1, std::memory_order_release);
+
+    errno = savedErrno;
+}
+
+// Read a thread name from /proc
+static std::string ThreadName(uint32_t threadId)
+{
+    char path[64];
+    char name[32] = {};
+    snprintf(path, sizeof(path), "/proc/self/task/%u/comm", threadId);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    ssize_t length = fd >= 0 ? read(fd, name, sizeof(name) - 1) : -1;
+    if (fd >= 0)
+        close(fd);
+    if (length > 0 && name[length - 1] == '\n')
+        name[length - 1] = 0;
+    if (length <= 0)
+        snprintf(name, sizeof(name), "%u", threadId);
+
+    // Separators within the folded stack format
+    for (char* c = name; *c != 0; c++)
+    {
+        if (*c == ';' || *c == ' ')
+            *c = '_';
+    }
+    return name;
+}
+
+// Add the completed samples of a round to the aggregated call stacks
+static void AggregateSamples(uint32_t sampleCnt, uint32_t sent)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    uint64_t round = ++_stats.Rounds;
+    uint32_t captured = 0;
+
+    for (uint32_t s = 0; s < sampleCnt; s++)
+    {
+        // A capture still writing is never read
+        const WallSample* sample = &_samples[s];
+        uint32_t threadId = __atomic_load_n(&sample->ThreadId, __ATOMIC_ACQUIRE);
+        if (threadId == 0)
+            continue;
+        captured++;
+
+        auto found = _threads.find(threadId);
+        if (found == _threads.end())
+        {
+            WallThread thread = { ThreadName(threadId), 0, NULL };
+            found = _threads.emplace(threadId, thread).first;
+        }
+        WallThread* thread = &found->second;
+
+        // A repeat of the sample aggregated in the previous round only
+        // increments its count
+        if (sample->Repeat && thread->Round + 1 == round && thread->Count != NULL)
+        {
+            (*thread->Count)++;
+            _stats.Repeats++;
+        }
+        else
+        {
+            uint32_t depth = sample->Depth < WALL_PROFILER_STACK_DEPTH ? sample->Depth : WALL_PROFILER_STACK_DEPTH;
+            std::vector<INTEGER_TYPE> stack(sample->Frames, sample->Frames + depth);
+            uint64_t* count = &_stacks[std::make_pair(thread->Name, std::move(stack))];
+            (*count)++;
+            thread->Count = count;
+        }
+        thread->Round = round;
+    }
+
+    // Forget exited threads; their IDs may be reused
+    for (auto it = _threads.begin(); it != _threads.end();)
+    {
+        if (it->second.Round != round)
+            it = _threads.erase(it);
+        else
+            ++it;
+    }
+
+    _stats.Samples += captured;
+    _stats.Missed += sent > captured ? sent - captured : 0;
+}
+
+// Capture the call stacks of every thread, bounded by the interval
+static void SampleRound()
+{
+    // Captures still writing from the previous round; skip this interval
+    uint32_t previous = _claimed.load();
+    if (_done.load(std::memory_order_acquire) < previous)
+        return;
+    if (previous > WALL_PROFILER_MAX_THREADS)
+        previous = WALL_PROFILER_MAX_THREADS;
+    for (uint32_t s = 0; s < previous; s++)
+        _samples[s].ThreadId = 0;
+
+    _claimed = 0;
+    _done = 0;
+    _collecting = true;
+
+    uint32_t sent = StackCaptureSignalAll(WALL_PROFILER_SIGNAL, _samplerThreadId);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_config.IntervalMs);
+    while (_done.load(std::memory_order_acquire) < sent && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+
+    // Late captures no longer write; wait for those already writing with
+    // their own bound
+    _collecting = false;
+    uint32_t claimed = _claimed.load();
+    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(WALL_PROFILER_DRAIN_MS);
+    while (_done.load(std::memory_order_acquire) < claimed && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+
+    AggregateSamples(claimed < WALL_PROFILER_MAX_THREADS ? claimed : WALL_PROFILER_MAX_THREADS, sent);
+}
+
+static void SamplerThread()
+{
+#ifdef USE_LINUX_SIGNALS
+    SignalFaultThread signalFaultThread;
+#endif
+    _samplerThreadId = (int)syscall(SYS_gettid);
+
+    std::unique_lock<std::mutex> lock(_lock);
+    while (!_stop)
+    {
+        _wake.wait_for(lock, std::chrono::milliseconds(_config.IntervalMs));
+        if (_stop)
+            break;
+        lock.unlock();
+        SampleRound();
+        lock.lock();
+    }
+}
+
+bool WallProfilerStart(const WallProfilerConfig* config)
+{
+    if (_sampler.joinable())
+        return false;
+
+    _config = *config;
+    if (_config.IntervalMs == 0)
+        _config.IntervalMs = WALL_PROFILER_INTERVAL_MS;
+
+    StackCaptureInit();
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = CaptureSignalHandler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(WALL_PROFILER_SIGNAL, &action, &_previousAction) != 0)
+        return false;
+
+    _stop = false;
+    _sampler = std::thread(SamplerThread);
+    return true;
+}
+
+void WallProfilerStop()
+{
+    if (!_sampler.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _stop = true;
+    }
+    _wake.notify_all();
+    _sampler.join();
+
+    sigaction(WALL_PROFILER_SIGNAL, &_previousAction, NULL);
+}
+
+bool WallProfilerWriteFolded(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+        return false;
+
+    // Call stacks differing only in addresses within the same functions
+    // are merged
+    std::unordered_map<INTEGER_TYPE, std::string> symbols;
+    std::map<std::string, uint64_t> folded;
+    std::unique_lock<std::mutex> lock(_lock);
+    for (const auto& entry : _stacks)
+    {
+        const std::vector<INTEGER_TYPE>& stack = entry.first.second;
+        std::string line = entry.first.first;
+        if (!stack.empty())
+            line += ';' + StackCaptureFolded(stack.data(), (uint32_t)stack.size(), &symbols);
+        folded[line] += entry.second;
+    }
+    lock.unlock();
+
+    for (const auto& entry : folded)
+        fprintf(file, "%s %llu\n", entry.first.c_str(), (unsigned long long)entry.second);
+
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
+
+WallProfilerStats WallProfilerGetStats()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    WallProfilerStats stats = _stats;
+    stats.Stacks = _stacks.size();
+    return stats;
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef _WALL_PROFILER_H
+#define _WALL_PROFILER_H
+
+// Wall-clock (off-CPU) sampling profiler. Unlike the CPU time profiler
+// (Profiler.h), every thread of the process is sampled at a fixed wall-clock
+// interval whether it is running or blocked on a lock or I/O, so waits
+// appear in the profile. No thread registration is needed.
+//
+// A sampler thread sends WALL_PROFILER_SIGNAL to every thread using
+// tgkill(), as SnapshotTake() does, and each thread captures its own call
+// stack within the signal handler using StackCaptureSignal(). A thread
+// hashes its call stack; a sample identical to the thread's previous sample
+// is marked as a repeat and only increments the count of that stack, so an
+// idle thread costs one unwind and no aggregation per interval.
+//
+// Blocking calls are restarted after the signal (SA_RESTART), except those
+// never restarted by Linux, e.g. nanosleep() and poll(), which return EINTR.
+// A thread blocking the signal is counted as missed.
+//
+// WallProfilerWriteFolded() writes the samples in the folded stack format
+// with the thread name as the root frame. Each count is one interval:
+//
+//   worker;main;Call1;pthread_cond_wait 42
+
+#include "CoreDump.h"
+#include <stdint.h>
+
+#ifdef __linux__
+
+// Default sample interval
+#define WALL_PROFILER_INTERVAL_MS       10
+
+// Maximum time to then wait for the captures already writing. A capture
+// still writing is missed, and the next interval is skipped.
+#define WALL_PROFILER_DRAIN_MS          2
+
+// Maximum number of threads sampled per interval
+#define WALL_PROFILER_MAX_THREADS       256
+
+// Call stack depth stored per sample
+#define WALL_PROFILER_STACK_DEPTH       32
+
+/// Wall-clock profiler configuration
+struct WallProfilerConfig
+{
+    uint32_t IntervalMs;        // Wall-clock time between samples of every thread
+};
+
+/// Wall-clock profiler statistics
+struct WallProfilerStats
+{
+    uint64_t Rounds;            // Intervals sampled
+    uint64_t Samples;           // Thread call stacks captured
+    uint64_t Repeats;           // Samples identical to the thread's previous sample
+    uint64_t Missed;            // Threads not responding within the interval
+    uint64_t Stacks;            // Distinct aggregated call stacks
+};
+
+/// Start the sampler thread and install the capture signal handler.
+/// @param[in] config - the profiler configuration
+/// @return True if started; false if already started.
+bool WallProfilerStart(const WallProfilerConfig* config);
+
+/// Stop the sampler thread. The aggregated samples remain available to
+/// WallProfilerWriteFolded().
+void WallProfilerStop();
+
+/// Write the aggregated samples in folded stack format.
+/// @param[in] path - the output file
+/// @return True if written.
+bool WallProfilerWriteFolded(const char* path);
+
+/// Get the wall-clock profiler statistics
+WallProfilerStats WallProfilerGetStats();
+
+#endif
+#endif
@@ -6,6 +6,39 @@
 
 #include "Fault.h"
 #include "CoreDump.h"
+#include "ClockCalibrator.h"
+#ifdef USE_COLLECTOR
+#include "CollectorClient.h"
+#endif
+#ifdef USE_UPLOADER
+#include "Uploader.h"
+#endif
+#ifdef USE_FAST_BOOT
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#endif
+#ifdef USE_ASSERT_SITES
+#include <cstdio>
+#endif
+#ifdef USE_STACK_BOUNDS
+#include "StackBounds.h"
+#endif
+#ifdef USE_STACK_PAINT
+#include "StackPaint.h"
+#endif
+#ifdef USE_SAFE_READ
+#include "SafeRead.h"
+#endif
+#ifdef USE_PROFILER
+#include "Profiler.h"
+#endif
+#ifdef USE_SNAPSHOT
+#include "Snapshot.h"
+#endif
+#ifdef USE_WALL_PROFILER
+#include "WallProfiler.h"
+#endif
 
 #ifdef HARD_FAULT_TEST
 static int val = 2, zero = 0, result;
@@ -52,6 +85,50 @@ int Call1()
 //----------------------------------------------------------------------------
 // main
 //----------------------------------------------------------------------------
+#ifdef USE_FAST_BOOT
+// Deferred persistence task. Validates and persists each core dump slot found 
+// at boot. A slot is released for future faults only once its core dump is 
+// persisted; otherwise it is detected again at the next boot.
+// TODO: Run as a low priority task on your OS.
+static std::atomic<bool> _persistStop(false);
+
+static void PersistCoreDumps(uint32_t pendingSlots)
+{
+#ifdef USE_LINUX_SIGNALS
+    SignalFaultThread signalFaultThread;
+#endif
+    for (uint32_t slot = 0; slot < CORE_DUMP_SLOT_CNT; slot++)
+    {
+        if (!(pendingSlots & (1u << slot)))
+            continue;
+
+        // A corrupt slot is not worth keeping
+        if (!CoreDumpSlotValid(slot))
+        {
+            CoreDumpSlotRelease(slot);
+            continue;
+        }
+
+        // TODO: Save core dump to persistent storage or transmit.
+#if defined(USE_UPLOADER)
+        // The uploader releases the slot once the copy is durable. A slot 
+        // not submitted before exit is detected again at the next boot.
+        while (!UploaderSubmit(CoreDumpSlotGet(slot)))
+        {
+            if (_persistStop)
+                return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+#elif defined(USE_COLLECTOR)
+        if (CollectorSendDump(COLLECTOR_SOCKET_PATH, CoreDumpSlotGet(slot)))
+            CoreDumpSlotRelease(slot);
+#else
+        CoreDumpSlotRelease(slot);
+#endif
+    }
+}
+#endif
+
 int main(void)
 {
     // Mark the beginning of the stack with a marker pattern. Each task in the 
@@ -59,11 +136,84 @@ int main(void)
     // this, but just incase here is a manual method. 
     unsigned int stackArr0[5] = { STACK_MARKER, STACK_MARKER, STACK_MARKER, STACK_MARKER, STACK_MARKER };
 
+#ifdef USE_FAST_BOOT
+    // Detect saved core dumps with one cache line read, before any fault 
+    // handler is installed or thread started, and persist them after 
+    // startup. Bit errors are repaired by the persistence task.
+    uint32_t pendingSlots = CoreDumpBootDetect();
+#endif
+
+    // Calibrate the core dump fault timestamps against the wall clock and 
+    // refresh the calibration periodically
+    ClockCalibratorStart(CLOCK_CALIBRATOR_INTERVAL_MS);
+
+#ifdef USE_STACK_BOUNDS
+    // Register the main thread stack bounds. Each thread registers its own 
+    // stack on thread start and unregisters it before exit.
+    StackBoundsRegisterThread();
+#endif
+
+#ifdef USE_STACK_PAINT
+    // Measure the main thread peak stack usage. Other stacks are painted 
+    // and registered when created.
+    StackPaintRegisterThread("main", STACK_PAINT_MAIN_SIZE);
+#endif
+
+#ifdef USE_SAFE_READ
+    // Cache the mappings read while storing a core dump
+    SafeReadInit();
+#endif
+
+#ifdef USE_PROFILER
+    // Sample this thread's call stacks. Other threads call 
+    // ProfilerRegisterThread() on start.
+    ProfilerConfig profilerConfig = { PROFILER_SAMPLE_HZ, PROFILER_DRAIN_MS };
+    ProfilerStart(&profilerConfig);
+#endif
+
+#ifdef USE_SNAPSHOT
+    // Snapshot all thread call stacks on kill -USR2 <pid>
+    SnapshotInstall(SNAPSHOT_STORE_PATH);
+#endif
+
+#ifdef USE_WALL_PROFILER
+    // Sample every thread's call stack, including blocked threads
+    WallProfilerConfig wallProfilerConfig = { WALL_PROFILER_INTERVAL_MS };
+    WallProfilerStart(&wallProfilerConfig);
+#endif
+
+#ifdef USE_LINUX_SIGNALS
+    // Connect fatal signals to the core dump. HARD_FAULT_TEST raises SIGFPE.
+    SignalFaultInstall();
+#endif
+
+#ifdef USE_MODULE_RELATIVE_STACK
+    // Record the loaded modules used to encode call stack addresses
+    CoreDumpModulesInit();
+#endif
+
 #ifdef USE_HARDWARE
     // Enable divide by 0 hardware exception
     SCB->CCR |= 0x10;
 #endif
 
+#ifdef USE_UPLOADER
+    // Upload persisted core dumps in the background at a limited rate
+    UploaderConfig uploaderConfig = { "coredump.store", "coredump.cursor", 
+        COLLECTOR_SOCKET_PATH, UPLOADER_RATE_BYTES, UPLOADER_BURST_BYTES };
+    UploaderStart(&uploaderConfig);
+#endif
+
+#ifdef USE_FAST_BOOT
+    std::thread persistThread;
+    if (pendingSlots != 0)
+        persistThread = std::thread(PersistCoreDumps, pendingSlots);
+#else
+#ifdef USE_ECC_STORAGE
+    // Repair any RAM bit errors within the saved core dump
+    CoreDumpEccRepair();
+#endif
+
     // Did a core dump get saved? i.e. Did CPU start due to a FaultHandler or
     // HardFaultHandler reset?
     if (IsCoreDumpSaved() == true)
@@ -73,14 +223,71 @@ int main(void)
 
         // TODO: Save core dump to persistent storage or transmit.
         // Platform-specific implementation detail on where to persist the RAM 
-        // core dump data to a permanent storage device.
+        // core dump data to a permanent storage device. The uploader and 
+        // collector client send compressed streams (Compress.h).
+#if defined(USE_UPLOADER)
+        // Persist and forward to the collector on the uploader thread. The 
+        // uploader resets the core dump once it is durable in the store.
+        UploaderSubmit(coreDumpData);
+#else
+#if defined(USE_COLLECTOR)
+        // Forward to the local crash collector daemon (Collector/)
+        CollectorSendDump(COLLECTOR_SOCKET_PATH, coreDumpData);
+#endif
 
         // Reset core dump for next time. 
         CoreDumpReset();
+#endif
     }
+#endif
 
     // Create call stack by calling a few functions
     Call1();
 
+#ifdef USE_ASSERT_SITES
+    // Report the assertion sites that failed
+    for (uint32_t id = 0; id < AssertSiteCount(); id++)
+    {
+        const AssertSite* site = AssertSiteGet(id);
+        uint64_t failures = site->Failures.load(std::memory_order_relaxed);
+        if (failures != 0)
+            printf("Assert site %u %s:%u failed %llu times\n", id, site->File, site->Line,
+                (unsigned long long)failures);
+    }
+#endif
+
+#ifdef USE_PROFILER
+    ProfilerStop();
+    ProfilerWriteFolded("profile.folded");
+#endif
+
+#ifdef USE_SNAPSHOT
+    SnapshotUninstall();
+#endif
+
+#ifdef USE_WALL_PROFILER
+    WallProfilerStop();
+    WallProfilerWriteFolded("wall.folded");
+#endif
+
+#ifdef USE_FAST_BOOT
+    // Don't exit while a core dump is half persisted
+    _persistStop = true;
+    if (persistThread.joinable())
+        persistThread.join();
+#endif
+
+#ifdef USE_UPLOADER
+    UploaderStop();
+#endif
+
+    ClockCalibratorStop();
+
+#ifdef USE_FAST_BOOT
+    CoreDumpBootStats bootStats = CoreDumpBootGetStats();
+    printf("Core dump boot detect %llu ns, persisted after %llu ns\n", 
+        (unsigned long long)bootStats.DetectNs, (unsigned long long)bootStats.PersistNs);
+#endif
+
     return stackArr0[0];
 }